@@ -0,0 +1,49 @@
+/*
+ * Checks Gdsd_moments_gauge against exponential drop size
+ * distributions, N(D) = N0 exp(-L D), for which
+ *
+ *     D0 = 3.67/L   and   Dm = 4/L
+ *
+ * (untruncated).  Counts are made up per size class as
+ * N(D) A T v(D) dD, the inverse of what the moments assume.
+ *
+ * Prints the moments and exits nonzero if either diameter is more
+ * than 5% off.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "gsl.h"
+
+#define N0   8000.0    /* m^-3 mm^-1, Marshall-Palmer. */
+#define AREA 0.005     /* m^2, as gsl_dsd.c. */
+
+int main(int argc, char **argv)
+{
+  static float lambda[] = {2.0, 2.5, 3.0, 4.0};
+  Gauge *g;
+  Gdsd_moments m;
+  float d, dd, v, d0, dm;
+  int i, k, nbad = 0;
+
+  g = Gnew_gauge(1, GSL_DSD_NBIN);
+  if (g == NULL) exit(-1);
+  g->h.nbin = GSL_DSD_NBIN;
+  g->h.resolution = 1;   /* Minutes. */
+
+  for (k=0; k<sizeof(lambda)/sizeof(lambda[0]); k++) {
+	for (i=0; i<GSL_DSD_NBIN; i++) {
+	  Gdsd_bin_size(i, &d, &dd, &v);
+	  g->record[0].value[i] = N0*exp(-lambda[k]*d)*AREA*60*v*dd;
+	}
+	Gdsd_moments_gauge(g, &m);
+	d0 = 3.67/lambda[k];
+	dm = 4.0/lambda[k];
+	printf("L %.1f: D0 %.3f (expect %.3f)  Dm %.3f (expect %.3f)\n",
+		   lambda[k], m.d0, d0, m.dm, dm);
+	if (fabs(m.d0 - d0) > 0.05*d0 || fabs(m.dm - dm) > 0.05*dm) nbad++;
+  }
+  Gfree_gauge(g);
+  if (nbad) fprintf(stderr, "%s: %d distributions off.\n", argv[0], nbad);
+  exit(nbad ? 1 : 0);
+}
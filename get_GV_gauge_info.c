@@ -31,46 +31,34 @@ int get_gauge_networks_for_radar_site(char *top_dir, char *radar_id,
 		         -1, otherwise.
 	*/
 
-	FILE     *fp;
-	char     buffy[1000], radar_file[300];
-	char     radar[8];
-	char     gnet[8], gv_site[8];
+	Gradar_catalog *cat;
+	Gradar_entry   *e;
+	char     radar_file[300];
 	int      net_index, verbose=1;
-	float    rlat, rlon;
 	strcpy(radar_file, top_dir);   
 	strcat(radar_file, "/sitelist/");
 	strcat(radar_file,"radar.dat"); 
 
-	if((fp = fopen(radar_file,"r"))== NULL){
+	/* The file is read and indexed once per process; see gsl_catalog.c. */
+	if((cat = Gradar_catalog_for(radar_file))== NULL){
 		fprintf(stderr,"Cannot open %s\n", radar_file);
 		return(-1);
 	}
 
-	/* Read in each line from the file 'radar.dat'.
-	 * Understands comments w/ # in the first column.  Headers must
-	 * be comments.
-	 */
 	net_index = 0;
-	while (fgets(buffy, sizeof(buffy), fp) != NULL){
-	  if (buffy[0] == '#') continue; /* Skip commented lines. */
-	  sscanf(buffy, "%s %s %s %f %f", gv_site, gnet, radar, &rlat, &rlon);
-	  if(verbose)
-	    fprintf(stderr, "%s %s %s %.2f %.2f\n", gv_site,
-		    gnet, radar, rlat, rlon);
-	  if(strcmp(radar_id, radar)==0){
+	for (e = Gfind_radar_entries(cat, radar_id); e != NULL;
+		 e = (e->next_in_radar < 0) ? NULL : &cat->entry[e->next_in_radar]){
 	    if (verbose)
-	      fprintf(stderr,"  Found network: %s in %s\n", gnet, radar_id);
-	    networks[net_index] = (char *) strdup(gnet);
+	      fprintf(stderr,"  Found network: %s in %s\n", e->network, radar_id);
+	    networks[net_index] = (char *) strdup(e->network);
 	    if (net_index == 0){
-	      *radarLat = rlat;
-	      *radarLon = rlon;
+	      *radarLat = e->lat;
+	      *radarLon = e->lon;
 	    }
 	    net_index++;
 	    if (net_index >= MAX_GAUGE_NETWORKS) return(-1);
-	  }
-	} /* end while (fscanf... */
+	} /* end for (e = ... */
 	*number_gnet = net_index;
-	fclose(fp);
 	return(0);
 }
 
@@ -170,7 +158,8 @@ Gauge_list *get_gauge_sites_info(char *top_dir, char *gnet,
 		 Returns: gauge_list, if success.
 		          NULL, otherwise.
 	 */
-	int     gauge_index;
+	int     gauge_index, i;
+	float   *lat, *lon, *range, *azim;
 	char    sitenumber[5], name[32];
 	char    sitefile[120];
 	char    line[128];
@@ -213,10 +202,6 @@ Gauge_list *get_gauge_sites_info(char *top_dir, char *gnet,
 		  glist->g[gauge_index].lon = lond + lonm/60. + lons/3600.;
 		else  /* lond < 0 */
 		  glist->g[gauge_index].lon = lond - lonm/60. - lons/3600.;
-		/* Compute gauge range & azimuth, and store in Gauge_list node. */
-		gauge_range_azimuth(radarLat, radarLon, glist->g[gauge_index].lat,
-							glist->g[gauge_index].lon, &glist->g[gauge_index].range,
-							&glist->g[gauge_index].azimuth);
 		gauge_index++;
 		if (gauge_index >= glist->ngauges){
 			fprintf(stderr, "get_site_info(): Too many gauges: %d\n",
@@ -224,7 +209,30 @@ Gauge_list *get_gauge_sites_info(char *top_dir, char *gnet,
 			return(NULL);
 		}
 	} /* end while(fgets... */
+	fclose(fp);
 	glist->ngauges = gauge_index;
+
+	/* Compute gauge range & azimuth for the whole list at once. */
+	lat   = (float *) malloc((gauge_index+1)*4*sizeof(float));
+	if (lat == NULL) {
+	  perror("get_gauge_sites_info");
+	  free_gauge_list(glist);
+	  return NULL;
+	}
+	lon   = lat + gauge_index+1;
+	range = lon + gauge_index+1;
+	azim  = range + gauge_index+1;
+	for (i=0; i<gauge_index; i++) {
+	  lat[i] = glist->g[i].lat;
+	  lon[i] = glist->g[i].lon;
+	}
+	gauge_range_azimuth_batch(radarLat, radarLon, gauge_index, lat, lon,
+							  range, azim);
+	for (i=0; i<gauge_index; i++) {
+	  glist->g[i].range   = range[i];
+	  glist->g[i].azimuth = azim[i];
+	}
+	free(lat);
 	return glist;
 }
 
@@ -232,7 +240,13 @@ Gauge_list *get_gauge_sites_info(char *top_dir, char *gnet,
 
 void free_gauge_list(Gauge_list *glist)
 {
+  int i;
+
   if (glist == NULL) return;
+  for (i=0; glist->g && i<glist->ngauges; i++) {
+	if (glist->g[i].site_id) free(glist->g[i].site_id);
+	if (glist->g[i].name) free(glist->g[i].name);
+  }
   if (glist->g) free(glist->g);
   free(glist);
 }
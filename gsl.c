@@ -38,10 +38,19 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #include "gsl.h"
 
-/* static int julian(int mo, int day, int year); */
+/* Approximate size, in bytes, of one disdrometer record:
+   "yyyy ddd hhmm" followed by 20 single digit bins. */
+#define DSD_RECORD_BYTES 54
+
 static void ymd(int jday, int yy, int *mm, int *dd);
+static int index_gauge_complex(Gauge_complex *gc);
 
 
 /***********************************************************************/
@@ -56,15 +65,16 @@ static int daytab[2][13] = {
   {0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366}
 };
 
-/*
-static int julian(int mo, int day, int year)
+int Gjulian(int mo, int day, int year)
 {
+  /* Day of the year, 1 for January 1st; mo is 1..12.  The inverse
+	 of ymd. */
   int leap;
 
+  if (mo < 1 || mo > 12) return 0;
   leap = (year%4 == 0 && year%100 != 0) || year%400 == 0;
   return day + daytab[leap][mo-1];
 }
-*/
 static void ymd(int jday, int yy, int *mm, int *dd)
 {
   /*  Input: jday, yy */
@@ -79,6 +89,91 @@ static void ymd(int jday, int yy, int *mm, int *dd)
   *dd = jday - daytab[leap][i];
 }
 
+/*************************************************************/
+/*                                                           */
+/*                        Time keys                          */
+/*                                                           */
+/*************************************************************/
+/* A Gtime_key is the number of seconds since 1970-01-01 00:00:00.
+   One integer comparison orders two records the same way the year,
+   jday, hour, minute, sec fields do (to the whole second; the fraction
+   of sec is dropped, see gsl.h), and the difference of two keys is the
+   time between them.
+*/
+#define SEC_PER_DAY 86400
+
+static long floor_div(long a, long b)
+{
+  return (a >= 0) ? a/b : -((-a + b - 1)/b);
+}
+
+static long days_before_year(int year)
+{
+  /* Days from 1970-01-01 to January 1st of 'year'. */
+  long y = year - 1;
+  return 365L*(year - 1970)
+	+ (floor_div(y, 4) - 492) - (floor_div(y, 100) - 19)
+	+ (floor_div(y, 400) - 4);
+}
+
+Gtime_key Gmake_time_key(int year, int jday, int hour, int minute, float sec)
+{
+  /* jday is the day of the year, 1 for January 1st (see ymd). */
+  return ((Gtime_key)(days_before_year(year) + jday - 1))*SEC_PER_DAY
+	+ hour*3600 + minute*60 + (int)sec;
+}
+
+Gtime_key Gtime_to_key(Gauge_time *t)
+{
+  return Gmake_time_key(t->year, t->jday, t->hour, t->minute, t->sec);
+}
+
+void Gkey_to_time(Gtime_key key, Gauge_time *t)
+{
+  /* Fills every field of 't' from 'key'. */
+  long days, secs;
+  int year;
+
+  days = (long)((key >= 0) ? key/SEC_PER_DAY : -((-key + SEC_PER_DAY - 1)/SEC_PER_DAY));
+  secs = (long)(key - (Gtime_key)days*SEC_PER_DAY);
+  year = 1970 + (int)floor_div(days, 365);
+  while (days_before_year(year) > days) year--;
+  while (days_before_year(year+1) <= days) year++;
+  t->year   = year;
+  t->jday   = (int)(days - days_before_year(year)) + 1;
+  ymd(t->jday, t->year, &t->month, &t->day);
+  t->hour   = secs/3600;
+  t->minute = (secs/60)%60;
+  t->sec    = secs%60;
+  t->key    = key;
+}
+
+void Gset_gauge_time_keys(Gauge *g)
+{
+  /* Recomputes record[].time.key from the broken-down fields. */
+  int j;
+
+  if (g == NULL) return;
+  for (j=0; j<g->h.nobs; j++)
+	g->record[j].time.key = Gtime_to_key(&g->record[j].time);
+}
+
+void Gcheck_gauge_time_keys(Gauge *g)
+{
+  /* Calls Gset_gauge_time_keys when the first or last record's key
+	 does not match its fields, as in a gauge built by hand whose keys
+	 were left 0.  The sort, merge, query, accumulation and resampling
+	 functions call this; a record edited in the middle of a gauge
+	 still needs Gset_gauge_time_keys.
+  */
+  int n;
+
+  if (g == NULL || g->record == NULL || (n = g->h.nobs) <= 0) return;
+  if (g->record[0].time.key != Gtime_to_key(&g->record[0].time) ||
+	  g->record[n-1].time.key != Gtime_to_key(&g->record[n-1].time))
+	Gset_gauge_time_keys(g);
+}
+
 /*************************************************************/
 /*                                                           */
 /*                      Gprint_network                       */
@@ -93,6 +188,10 @@ void Gprint_network(Gauge_network *gnet)
   for (i = 0; i<gnet->h.ngauge; i++) {
 	g = gnet->gauge[i];
 	printf("------------< Gauge # %d of %d>------------\n", i+1,gnet->h.ngauge);
+	if (g == NULL) {
+	  printf("  (Not read; see Ghdf_gauge)\n");
+	  continue;
+	}
 	printf("  Name: %s\n", g->h.name);
 	printf("  Number: %d\n", g->h.number);
 	printf("  Type: %s, Lat %f, Lon %f\n", g->h.type, g->h.lat, g->h.lon);
@@ -106,8 +205,10 @@ void Gprint_network(Gauge_network *gnet)
 /*************************************************************/
 void Gfree_gauge(Gauge *g)
 {
-  if (g != NULL)
+  /* A gauge that lives in an arena is freed with its arena. */
+  if (g != NULL && g->arena == NULL)
 	{
+		if (g->h.name)       free(g->h.name);  /* The rest are interned. */
 		if (g->record != NULL)
 		{
 			if (g->record->value != NULL)
@@ -160,6 +261,9 @@ void Gfree_gauge_network(Gauge_network *net)
 	
 	if (net != NULL)
 	{
+		Gfree_index(net->by_number);
+		Gfree_index(net->by_name);
+		if (net->arena != NULL) return; /* Freed with its arena. */
 		if (net->gauge != NULL)
 		{
 			for (j=0; j<net->h.ngauge; j++)
@@ -204,12 +308,23 @@ void Gfree_gauge_complex(Gauge_complex *gc)
 	
 	if (gc != NULL)
 	{
+		if (gc->arena != NULL)
+		{
+			/* Only the lookup tables are outside the arena. */
+			for (j=0; j<gc->h.nnet; j++)
+			  Gfree_gauge_network(gc->net[j]);
+			Gfree_index(gc->by_name);
+			if (gc->map) munmap(gc->map, gc->map_len);
+			Gfree_arena(gc->arena);
+			return;
+		}
 	  if (gc->net != NULL)
 		{
 	    for (j=0; j<gc->h.nnet; j++)
 	      Gfree_gauge_network(gc->net[j]);
 			free(gc->net);
 		}
+		Gfree_index(gc->by_name);
 		free(gc);
 	}
 }
@@ -230,6 +345,33 @@ Gauge_complex *Gnew_gauge_complex(int nnet)
 	return(gc);
 }
 
+Gauge_complex *Gnew_gauge_complex_arena(int nnet)
+{
+	/* Like Gnew_gauge_complex, but the complex gets an arena of its
+		 own.  Networks and gauges added by Gconstruct_gauge_complex_arena
+		 go into that arena, and Gfree_gauge_complex releases it all at
+		 once.  Gauges added to
+		 such a complex by hand must come from Garena_copy_gauge(gc->arena).
+	*/
+	Gauge_complex *gc;
+	Garena *arena;
+
+	arena = Gnew_arena(0);
+	if (arena == NULL) return(NULL);
+	gc = (Gauge_complex *)Garena_alloc(arena, sizeof(Gauge_complex));
+	if (gc == NULL) {
+		Gfree_arena(arena);
+		return(NULL);
+	}
+	gc->arena = arena;
+	gc->net = (Gauge_network **)Garena_alloc(arena, (nnet+1)*sizeof(Gauge_network *));
+	if (gc->net == NULL) {
+		Gfree_arena(arena);
+		return(NULL);
+	}
+	return(gc);
+}
+
 /*************************************************************/
 /*                                                           */
 /*                       Gprint_gauge                        */
@@ -265,25 +407,541 @@ void Gprint_gauge(Gauge *g)
 
 /*************************************************************/
 /*                                                           */
-/*                     copy_to_larger_obs                    */
+/*                     Gresize_gauge                         */
+/*                                                           */
+/*************************************************************/
+Gauge *Gresize_gauge(Gauge *g, int nobs)
+{
+  /* Grow (or trim) g so that it holds 'nobs' observations of h.nbin
+	 bins each.  The record and value arrays are realloc'ed in place,
+	 so 'g' itself does not move; existing observations are kept and
+	 new ones are zeroed.  Assumes the layout made by Gnew_gauge:
+	 record[j].value == record[0].value + j*nbin.
+
+	 Returns: g, if success.
+	          NULL, if out of memory or 'g' lives in an arena.  (g is
+	                then still valid, at its old size.)
+  */
+  Gauge_record *record;
+  float *value;
+  int j, old, nalloc, nvalue;
+
+  if (g == NULL || nobs < 0 || g->arena != NULL) return NULL;
+  old = g->h.nobs;
+  nalloc = (nobs > 0) ? nobs : 1;
+  nvalue = (nalloc*g->h.nbin > 0) ? nalloc*g->h.nbin : 1;
+
+  /* The values first: until the records move too, the records that
+   * are kept are pointed at the moved values, so 'g' stays whole
+   * whichever realloc fails.
+   */
+  value = (float *)realloc(g->record->value, nvalue*sizeof(float));
+  if (value == NULL) {
+	perror("Gresize_gauge -- g->record->value");
+	return NULL;
+  }
+  for (j=0; j<old && j<nalloc; j++)
+	g->record[j].value = value + j*g->h.nbin;
+  record = (Gauge_record *)realloc(g->record, nalloc*sizeof(Gauge_record));
+  if (record == NULL) {
+	if (nobs > old) {
+	  perror("Gresize_gauge -- g->record");
+	  return NULL;
+	}
+	record = g->record;  /* Trimming: the old array will do. */
+  }
+  g->record = record;
+  if (nobs > old) {
+	memset(&record[old], 0, (nobs - old)*sizeof(Gauge_record));
+	memset(&value[old*g->h.nbin], 0, (nobs - old)*g->h.nbin*sizeof(float));
+  }
+  for (j=0; j<nalloc; j++)
+	record[j].value = value + j*g->h.nbin;
+  g->h.nobs = nobs;
+  return g;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                     count_lines                           */
+/*                                                           */
+/*************************************************************/
+static int count_lines(char *buf, size_t len)
+{
+  char *p, *end = buf + len;
+  int n = 0;
+
+  for (p = buf; p < end && (p = memchr(p, '\n', end - p)) != NULL; p++)
+	n++;
+  if (len > 0 && buf[len-1] != '\n') n++;
+  return n;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                    Raw text scanning                      */
+/*                                                           */
+/*************************************************************/
+/* Replacements for the fscanf() conversions used by the raw file
+   readers.  They work on a mapped file image, [*p, end), and advance
+   *p past whatever they consume.  Like fscanf, every conversion first
+   skips white space.  Each returns 1 on success, 0 on end of data or
+   on a field that does not convert.
+*/
+#define IS_SPACE(c) ((c)==' ' || (c)=='\n' || (c)=='\t' || \
+                     (c)=='\r' || (c)=='\v' || (c)=='\f')
+#define IS_DIGIT(c) ((c)>='0' && (c)<='9')
+
+static int scan_space(char **p, char *end)
+{
+  char *s = *p;
+  while (s < end && IS_SPACE(*s)) s++;
+  *p = s;
+  return s < end;
+}
+
+static int scan_int(char **p, char *end, int width, int *val)
+{
+  /* "%d", or "%<width>d" when width > 0. */
+  char *s, *stop;
+  int neg = 0, v = 0;
+
+  if (!scan_space(p, end)) return 0;
+  s = *p;
+  stop = (width > 0 && s + width < end) ? s + width : end;
+  if (*s == '-' || *s == '+') {
+	neg = (*s == '-');
+	s++;
+  }
+  if (s >= stop || !IS_DIGIT(*s)) return 0;
+  while (s < stop && IS_DIGIT(*s))
+	v = v*10 + (*s++ - '0');
+  *val = neg ? -v : v;
+  *p = s;
+  return 1;
+}
+
+static int scan_float(char **p, char *end, float *val)
+{
+  /* "%f".  Plain decimals with at most 7 significant digits and a
+	 small exponent are converted exactly here: both the mantissa and
+	 the power of ten are exact floats, and a double division of two
+	 floats rounds to the same float as strtof() would.  Anything
+	 else is handed to strtof().
+  */
+  static double p10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5,
+						   1e6, 1e7, 1e8, 1e9, 1e10};
+  char *s, buf[64];
+  int neg = 0, ndigit = 0, scale = 0, e = 0, eneg = 0, n;
+  long m = 0;
+  double x;
+
+  if (!scan_space(p, end)) return 0;
+  s = *p;
+  if (*s == '-' || *s == '+') {
+	neg = (*s == '-');
+	s++;
+  }
+  while (s < end && *s == '0') {
+	s++;
+	ndigit = 1;    /* Leading zeros are digits, but not significant. */
+  }
+  for (; s < end && IS_DIGIT(*s); s++, ndigit++)
+	if (m < 100000000) m = m*10 + (*s - '0');
+	else scale++;
+  if (s < end && *s == '.')
+	for (s++; s < end && IS_DIGIT(*s); s++, ndigit++)
+	  if (m < 100000000) {
+		m = m*10 + (*s - '0');
+		scale--;
+	  }
+  if (ndigit == 0) goto slow;
+  if (s < end && (*s == 'e' || *s == 'E')) {
+	s++;
+	if (s < end && (*s == '-' || *s == '+')) eneg = (*s++ == '-');
+	if (s >= end || !IS_DIGIT(*s)) goto slow;
+	while (s < end && IS_DIGIT(*s) && e < 1000)
+	  e = e*10 + (*s++ - '0');
+	scale += eneg ? -e : e;
+  }
+  if (s < end && !IS_SPACE(*s)) goto slow;
+  if (m > 16777216 || scale < -10 || scale > 10) goto slow;
+
+  x = (scale < 0) ? (double)m / p10[-scale] : (double)m * p10[scale];
+  *val = (float)(neg ? -x : x);
+  *p = s;
+  return 1;
+
+ slow:
+  s = *p;
+  for (n = 0; s+n < end && !IS_SPACE(s[n]) && n < (int)sizeof(buf)-1; n++)
+	buf[n] = s[n];
+  buf[n] = '\0';
+  x = strtof(buf, &s);
+  if (s == buf) return 0;
+  *val = (float)x;
+  *p += s - buf;
+  return 1;
+}
+
+static int scan_word(char **p, char *end, char *buf, int size)
+{
+  /* "%s", truncated to fit 'buf'. */
+  char *s;
+  int n = 0;
+
+  if (!scan_space(p, end)) return 0;
+  for (s = *p; s < end && !IS_SPACE(*s); s++)
+	if (n < size-1) buf[n++] = *s;
+  buf[n] = '\0';
+  *p = s;
+  return 1;
+}
+
+static int scan_bins(char **p, char *end, float *value, int nbin)
+{
+  /* 'nbin' consecutive "%d" fields, decoded in one pass; this is the
+	 body of every disdrometer record.  Returns the number of bins
+	 converted.  A short count means end of data or a field that is
+	 not an integer; scan_space(p, end) tells the two apart.
+  */
+  char *s = *p;
+  int k, v, neg;
+
+  for (k=0; k<nbin; k++) {
+	while (s < end && IS_SPACE(*s)) s++;
+	if (s >= end) break;
+	neg = 0;
+	if (*s == '-' || *s == '+') {
+	  if (s+1 >= end || !IS_DIGIT(s[1])) break;
+	  neg = (*s++ == '-');
+	}
+	if (!IS_DIGIT(*s)) break;
+	v = *s++ - '0';
+	while (s < end && IS_DIGIT(*s))
+	  v = v*10 + (*s++ - '0');
+	value[k] = (float)(neg ? -v : v);
+  }
+  *p = s;
+  return k;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                     map_file / unmap_file                 */
+/*                                                           */
+/*************************************************************/
+static char *map_file(char *infile, size_t *len)
+{
+  /* Map 'infile' read-only.  Returns NULL, without complaint, for
+	 anything that cannot be mapped (missing, empty, not a regular
+	 file); callers fall back to stdio for those.
+  */
+  struct stat sb;
+  char *buf;
+  int fd;
+
+  fd = open(infile, O_RDONLY);
+  if (fd < 0) return NULL;
+  if (fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode) || sb.st_size == 0) {
+	close(fd);
+	return NULL;
+  }
+  buf = (char *)mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (buf == (char *)MAP_FAILED) return NULL;
+#ifdef MADV_SEQUENTIAL
+  madvise(buf, (size_t)sb.st_size, MADV_SEQUENTIAL);
+#endif
+  *len = (size_t)sb.st_size;
+  return buf;
+}
+
+static void unmap_file(char *buf, size_t len)
+{
+  if (buf != NULL) munmap(buf, len);
+}
+
+/*************************************************************/
+/*                                                           */
+/*             scan_gmin_header / scan_gmin_record           */
+/*                                                           */
+/*************************************************************/
+static int scan_gmin_header(char **p, char *end, Gauge *g)
+{
+  /* The header line of a GMIN file, into g->h. */
+  char name[16];
+  char type[16];
+  char network[16];
+  char gv_site[16];
+  char product[16];
+  char radar[16];
+
+  if (!(scan_word(p, end, product, sizeof(product)) &&
+		scan_word(p, end, gv_site, sizeof(gv_site)) &&
+		scan_word(p, end, network, sizeof(network)) &&
+		scan_int(p, end, 0, &g->h.number) &&
+		scan_word(p, end, name, sizeof(name)) &&
+		scan_word(p, end, type, sizeof(type)) &&
+		scan_float(p, end, &g->h.resolution) &&
+		scan_float(p, end, &g->h.lat) &&
+		scan_float(p, end, &g->h.lon) &&
+		scan_word(p, end, radar, sizeof(radar)) &&
+		scan_float(p, end, &g->h.range) &&
+		scan_float(p, end, &g->h.azimuth) &&
+		scan_float(p, end, &g->h.elevation)))
+	return 0;
+
+  g->h.radar= Gintern(radar);
+  g->h.name = (char *)strdup(name);
+  g->h.type = Gintern(type);
+  g->h.network    = Gintern(network);
+  g->h.product_id = Gintern(product);
+  g->h.gv_site    = Gintern(gv_site);
+  return 1;
+}
+
+static int scan_gmin_record(char **p, char *end, Gauge_record *r)
+{
+  /* One "yyyy ddd hh mm ss rate" observation, into 'r'. */
+  int yy, jday, hh, mm, ss;
+  float ob;
+
+  if (!(scan_int(p, end, 0, &yy) && scan_int(p, end, 0, &jday) &&
+		scan_int(p, end, 0, &hh) && scan_int(p, end, 0, &mm) &&
+		scan_int(p, end, 0, &ss) && scan_float(p, end, &ob)))
+	return 0;
+  r->time.year   = yy;
+  r->time.jday   = jday;
+  ymd(jday, yy, &r->time.month, &r->time.day);
+  r->time.hour   = hh;
+  r->time.minute = mm;
+  r->time.sec    = ss;
+  r->time.key    = Gmake_time_key(yy, jday, hh, mm, ss);
+  r->value[0] = ob;
+  return 1;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                     Gread_gmin_mmap                       */
 /*                                                           */
 /*************************************************************/
-Gauge *copy_to_larger_obs(Gauge *g_old, int n)
+static Gauge *new_parsed_gauge(Gauge *hdr, int nobs, int nbin, Garena *a)
 {
+  /* A gauge for the header in 'hdr', from arena 'a' if not NULL.
+	 hdr->h.name moves to the new gauge. */
   Gauge *g;
-  if (g_old == NULL) return NULL;
-/*  g = Gnew_gauge(n); */
-  g = Gnew_gauge(n, 20);
-  g->h = g_old->h;  /* Overwrites h.nobs.  See next line. */
-  g->h.nobs = n;    /* We'll check if this is enough, during read. */
-
-  /* Copy */
-  memcpy(g->record, g_old->record, sizeof(Gauge_record)*g_old->h.nobs);
-  free(g_old->record);
-  free(g_old);
+
+  g = (a != NULL) ? Garena_new_gauge(a, nobs, nbin) : Gnew_gauge(nobs, nbin);
+  if (g == NULL) {
+	if (hdr->h.name) free(hdr->h.name);
+	return NULL;
+  }
+  hdr->h.nobs = g->h.nobs;
+  hdr->h.nbin = g->h.nbin;
+  g->h = hdr->h;
+  if (a != NULL) {
+	g->h.name = Garena_strdup(a, hdr->h.name);
+	if (hdr->h.name) free(hdr->h.name);
+  }
   return g;
 }
-  
+
+static Gauge *grow_parsed_gauge(Gauge *g)
+{
+  /* Doubles 'g' for a file with more records than expected.  An arena
+	 gauge cannot grow, so it is copied out of the arena first (the
+	 arena copy is freed with the arena); settle_parsed_gauge puts it
+	 back.
+
+	 Returns: the gauge to go on with.
+	          NULL, if out of memory; 'g' is unchanged.
+  */
+  Gauge *h = g;
+
+  if (g->arena != NULL && (h = Gcopy_gauge(g)) == NULL) return NULL;
+  if (Gresize_gauge(h, 2*h->h.nobs) == NULL) {
+	if (h != g) Gfree_gauge(h);
+	return NULL;
+  }
+  return h;
+}
+
+static Gauge *settle_parsed_gauge(Gauge *g, int n, Garena *a)
+{
+  /* Trims 'g' to 'n' records and, if it had to leave arena 'a', moves
+	 it back.  Returns: the gauge, or NULL if out of memory. */
+  Gauge *ag;
+
+  if (Gresize_gauge(g, n) == NULL) g->h.nobs = n;
+  if (a == NULL || g->arena == a) return g;
+  ag = Garena_copy_gauge(a, g);
+  Gfree_gauge(g);
+  return ag;
+}
+
+Gauge *Gread_gmin_mmap(char *infile, Garena *a)
+{
+  /* Same result as Gread_gmin, but the file is parsed directly from
+	 a read-only mapping instead of through fscanf.  When 'a' is not
+	 NULL the gauge is built in arena 'a' (see Garena_new_gauge), as
+	 Gconstruct_gauge_complex does for an arena complex.
+
+	 Returns: gauge, if success.
+	          NULL, if the file cannot be mapped or its header record
+	                does not parse.  (Gread_gmin then uses stdio.)
+  */
+  Gauge *g, *ng, hdr;
+  int n;
+  char *buf, *p, *end;
+  size_t len;
+  int maxobs;
+
+  buf = map_file(infile, &len);
+  if (buf == NULL) return NULL;
+  p = buf;
+  end = buf + len;
+
+  /* The header record. */
+  memset(&hdr, 0, sizeof(hdr));
+  if (!scan_gmin_header(&p, end, &hdr)) {
+	if (hdr.h.name) free(hdr.h.name);
+	unmap_file(buf, len);
+	return NULL;
+  }
+
+  /* Normally one observation per line, so the line count is enough
+	 room: allocate once, and trim to size at the end.  A file with
+	 several on a line grows the gauge (see grow_parsed_gauge). */
+  maxobs = count_lines(buf, len);
+  g = new_parsed_gauge(&hdr, maxobs, 1, a);
+  if (g == NULL) {
+	unmap_file(buf, len);
+	return NULL;
+  }
+
+  n = 0;
+  while (scan_space(&p, end)) {
+	if (!scan_gmin_record(&p, end, &g->record[n])) {
+	  fprintf(stderr, "Gread_gmin: %s: bad observation after record %d; "
+			  "remainder ignored.\n", infile, n);
+	  break;
+	}
+	n++;
+	if (n >= g->h.nobs) {
+	  if ((ng = grow_parsed_gauge(g)) == NULL) {
+		fprintf(stderr, "Gread_gmin: %s: out of memory after record %d; "
+				"remainder ignored.\n", infile, n);
+		break;
+	  }
+	  g = ng;
+	}
+  }
+  unmap_file(buf, len);
+  return settle_parsed_gauge(g, n, a);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                    Gread_disdro_mmap                      */
+/*                                                           */
+/*************************************************************/
+Gauge *Gread_disdro_mmap(char *infile, Garena *a)
+{
+  /* Same result as Gread_disdro_gauge, but parsed directly from a
+	 read-only mapping.  The 20 drop size bins of a record are decoded
+	 by a single scan_bins() call rather than 20 fscanf()s.  When 'a'
+	 is not NULL the gauge is built in arena 'a', as for Gread_gmin_mmap.
+
+	 Returns: gauge, if success.
+	          NULL, if the file cannot be mapped or its header record
+	                does not parse.  (Gread_disdro_gauge then uses stdio.)
+  */
+  Gauge *g, *ng, hdr;
+  char name[16];
+  char type[16];
+  char network[16];
+  int k, n, yy, jday, hh, mm;
+  char *buf, *p, *end;
+  size_t len;
+  int maxobs;
+
+  buf = map_file(infile, &len);
+  if (buf == NULL) return NULL;
+  p = buf;
+  end = buf + len;
+
+  /* The header record. */
+  memset(&hdr, 0, sizeof(hdr));
+  if (!(scan_int(&p, end, 0, &hdr.h.number) &&
+		scan_word(&p, end, name, sizeof(name)) &&
+		scan_word(&p, end, network, sizeof(network)) &&
+		scan_word(&p, end, type, sizeof(type)) &&
+		scan_float(&p, end, &hdr.h.resolution) &&
+		scan_float(&p, end, &hdr.h.lat) &&
+		scan_float(&p, end, &hdr.h.lon) &&
+		scan_float(&p, end, &hdr.h.elevation) &&
+		scan_float(&p, end, &hdr.h.range) &&
+		scan_float(&p, end, &hdr.h.azimuth))) {
+	unmap_file(buf, len);
+	return NULL;
+  }
+  hdr.h.name = (char *) strdup(name);
+  hdr.h.type = Gintern(type);
+  hdr.h.network = Gintern(network);
+
+  /* Size the gauge from the file size.  A record with every bin a
+	 single digit is about DSD_RECORD_BYTES long, so this is normally
+	 the only allocation; the gauge is trimmed to size at the end.
+	 An arena gauge gets one record per line, since growing it means
+	 copying it (see grow_parsed_gauge). */
+  maxobs = (a != NULL) ? count_lines(buf, len) : len / DSD_RECORD_BYTES + 1;
+  g = new_parsed_gauge(&hdr, maxobs, 20, a);
+  if (g == NULL) {
+	unmap_file(buf, len);
+	return NULL;
+  }
+
+  n = 0;
+  while (scan_space(&p, end)) {
+	/* "%d %d %2d%2d" -- year, jday, hhmm. */
+	if (!(scan_int(&p, end, 0, &yy) && scan_int(&p, end, 0, &jday) &&
+		  scan_int(&p, end, 2, &hh) && scan_int(&p, end, 2, &mm))) {
+	  fprintf(stderr, "Gread_disdro_gauge: %s: bad time after record %d; "
+			  "remainder ignored.\n", infile, n);
+	  break;
+	}
+	g->record[n].time.year   = yy;
+	g->record[n].time.jday   = jday;
+	ymd(jday, yy, &g->record[n].time.month, &g->record[n].time.day);
+	g->record[n].time.hour   = hh;
+	g->record[n].time.minute = mm;
+	g->record[n].time.sec    = 0.0;
+	g->record[n].time.key    = Gmake_time_key(yy, jday, hh, mm, 0);
+	k = scan_bins(&p, end, g->record[n].value, 20);
+
+	n++;
+	if (n >= g->h.nobs) {
+	  if ((ng = grow_parsed_gauge(g)) == NULL) {
+		fprintf(stderr, "Gread_disdro_gauge: %s: out of memory after "
+				"record %d; remainder ignored.\n", infile, n);
+		break;
+	  }
+	  g = ng;
+	}
+	if (k < 20) {
+	  /* A short last record keeps its zero bins, as with fscanf. */
+	  if (scan_space(&p, end))
+		fprintf(stderr, "Gread_disdro_gauge: %s: bad bin in record %d; "
+				"remainder ignored.\n", infile, n);
+	  break;
+	}
+  }
+  unmap_file(buf, len);
+  return settle_parsed_gauge(g, n, a);
+}
+
 /*************************************************************/
 /*                                                           */
 /*                       Gread_gmin                          */
@@ -292,9 +950,12 @@ Gauge *copy_to_larger_obs(Gauge *g_old, int n)
 Gauge *Gread_gmin(char *infile)
 {
 	/* This function is nearly identical to function 'Gread_disdro_gauge'.
-		 Since I don't know if the finalized formats of gmin and disdro 
+		 Since I don't know if the finalized formats of gmin and disdro
 		 files will be the same, it's wise for now to keep 2 distinct
 		 functions.
+
+		 Regular files are parsed by Gread_gmin_mmap; the fscanf loop
+		 below handles whatever that cannot map (pipes, empty files).
   */
   FILE *fp;
   Gauge *g;
@@ -308,11 +969,13 @@ Gauge *Gread_gmin(char *infile)
   char radar[16];
 
  /* The default amount asked for is 2500 observations.  If this is
-  * not enough, then 2500 more are allocated -- the original is
-  * saved and new measurements are appended.  See copy_to_larger_obs.
+  * not enough, the gauge is doubled in place.  See Gresize_gauge.
   */
   int maxobs = 2500;
 
+  g = Gread_gmin_mmap(infile, NULL);
+  if (g != NULL) return g;
+
   fp = fopen(infile, "r");
   if (fp==NULL)
 	{
@@ -330,12 +993,12 @@ Gauge *Gread_gmin(char *infile)
 				 &g->h.lat, &g->h.lon, radar,
 				 &g->h.range, &g->h.azimuth, &g->h.elevation);
 
-  g->h.radar= (char *) strdup(radar);
+  g->h.radar= Gintern(radar);
   g->h.name = (char *)strdup(name);
-  g->h.type = (char *)strdup(type);
-  g->h.network    = (char *)strdup(network);
-  g->h.product_id = (char *)strdup(product);
-  g->h.gv_site    = (char *)strdup(gv_site);
+  g->h.type = Gintern(type);
+  g->h.network    = Gintern(network);
+  g->h.product_id = Gintern(product);
+  g->h.gv_site    = Gintern(gv_site);
 
   n = 0;
   while(fscanf(fp, "%d %d %d %d %d %f\n",
@@ -346,16 +1009,165 @@ Gauge *Gread_gmin(char *infile)
 	g->record[n].time.hour   = hh;
 	g->record[n].time.minute = mm;
 	g->record[n].time.sec    = ss;
+	g->record[n].time.key    = Gmake_time_key(yy, jday, hh, mm, ss);
 	g->record[n].value[0] = ob;
 	n++;
-	if (n >= g->h.nobs)
-	  g = copy_to_larger_obs(g, g->h.nobs + maxobs);
+	if (n >= g->h.nobs && Gresize_gauge(g, 2*g->h.nobs) == NULL) break;
   }
   fclose(fp);
-  g->h.nobs = n;
+  if (Gresize_gauge(g, n) == NULL) g->h.nobs = n;
   return g;
 }
 
+/*************************************************************/
+/*                                                           */
+/*              Gopen_follow / Gfollow_gmin                  */
+/*                                                           */
+/*************************************************************/
+Gfollow *Gopen_follow(char *infile)
+{
+  /* A handle for reading GMIN file 'infile' while it is still being
+	 written.  Nothing is read until Gfollow_gmin.
+
+	 Returns: handle, if success.  Free with Gclose_follow.
+	          NULL, if out of memory.
+  */
+  Gfollow *f;
+
+  if (infile == NULL) return NULL;
+  f = (Gfollow *)calloc(1, sizeof(Gfollow));
+  if (f == NULL || (f->file = (char *)strdup(infile)) == NULL) {
+	perror("Gopen_follow");
+	if (f) free(f);
+	return NULL;
+  }
+  return f;
+}
+
+void Gclose_follow(Gfollow *f)
+{
+  /* Frees the handle; f->g, if any, is the caller's to free. */
+  if (f == NULL) return;
+  free(f->file);
+  if (f->buf) free(f->buf);
+  free(f);
+}
+
+static int follow_line(Gfollow *f, char *line, char *nl)
+{
+  /* Parses one complete line [line, nl) into f->g. */
+  char *p = line;
+  int n;
+
+  if (!scan_space(&p, nl)) return OK;  /* Blank line. */
+  if (!f->have_header) {
+	if (f->g == NULL) {
+	  if ((f->g = Gnew_gauge(256, 1)) == NULL) return ABORT;
+	  f->nalloc = 256;
+	} else if (f->g->h.name) {
+	  free(f->g->h.name);
+	  f->g->h.name = NULL;
+	}
+	if (!scan_gmin_header(&p, nl, f->g)) {
+	  fprintf(stderr, "Gfollow_gmin: %s: bad header line.\n", f->file);
+	  return ABORT;
+	}
+	f->g->h.nobs = 0;
+	f->have_header = 1;
+	return OK;
+  }
+
+  n = f->g->h.nobs;
+  if (n == f->nalloc) {
+	if (Gresize_gauge(f->g, 2*f->nalloc) == NULL) {
+	  f->g->h.nobs = n;
+	  return ABORT;
+	}
+	f->nalloc *= 2;
+	f->g->h.nobs = n;
+  }
+  if (!scan_gmin_record(&p, nl, &f->g->record[n])) {
+	fprintf(stderr, "Gfollow_gmin: %s: bad observation after record %d; "
+			"line skipped.\n", f->file, n);
+	return OK;
+  }
+  f->g->h.nobs = n+1;
+  return OK;
+}
+
+int Gfollow_gmin(Gfollow *f)
+{
+  /* Reads what has been added to the file since the last call and
+	 appends its observations to f->g.  The first call reads the
+	 header line and creates f->g (the same gauge Gread_gmin would
+	 give).  Only complete lines are used: a last line still being
+	 written is left for the next call.
+
+	 If the file has been truncated or replaced, f->g is emptied and
+	 refilled from the start of the new file.
+
+	 Returns: the number of observations appended, if success.
+	          ABORT, if the file cannot be read or its header line
+	                 does not parse.
+  */
+  struct stat sb;
+  char *line, *nl, *end, *new_buf;
+  long long want;
+  ssize_t got;
+  int fd, n0;
+
+  if (f == NULL) return ABORT;
+  if ((fd = open(f->file, O_RDONLY)) < 0) {
+	perror(f->file);
+	return ABORT;
+  }
+  if (fstat(fd, &sb) != 0) {
+	perror(f->file);
+	close(fd);
+	return ABORT;
+  }
+  if ((long long)sb.st_size < f->offset ||
+	  (f->offset > 0 && (long)sb.st_ino != f->inode)) {
+	/* Start over; f->g stays the same object. */
+	f->offset = 0;
+	f->have_header = 0;
+	if (f->g) f->g->h.nobs = 0;
+  }
+  f->inode = (long)sb.st_ino;
+  n0 = f->g ? f->g->h.nobs : 0;
+
+  want = (long long)sb.st_size - f->offset;
+  if (want <= 0) {
+	close(fd);
+	return 0;
+  }
+  if (want > f->nbuf) {
+	new_buf = (char *)realloc(f->buf, (size_t)want);
+	if (new_buf == NULL) {
+	  perror("Gfollow_gmin");
+	  close(fd);
+	  return ABORT;
+	}
+	f->buf  = new_buf;
+	f->nbuf = want;
+  }
+  got = pread(fd, f->buf, (size_t)want, (off_t)f->offset);
+  close(fd);
+  if (got < 0) {
+	perror(f->file);
+	return ABORT;
+  }
+
+  end = f->buf + got;
+  for (line = f->buf; line < end; line = nl+1) {
+	nl = memchr(line, '\n', end - line);
+	if (nl == NULL) break;               /* Partial line: wait. */
+	if (follow_line(f, line, nl) != OK) return ABORT;
+	f->offset += nl+1 - line;
+  }
+  return (f->g ? f->g->h.nobs : 0) - n0;
+}
+
 /*************************************************************/
 /*                                                           */
 /*                       Gread_disdro_gauge                  */
@@ -371,11 +1183,14 @@ Gauge *Gread_disdro_gauge(char *infile)
   int val;
   int k, n, yy, jday, hh, mm;
  /* The default amount asked for is 2500 observations.  If this is
-  * not enough, then 2500 more are allocated -- the original is
-  * saved and new measurements are appended.  See copy_to_larger_obs.
+  * not enough, the gauge is doubled in place.  See Gresize_gauge.
   */
   int maxobs = 2500;
 
+  /* Regular files are parsed by Gread_disdro_mmap. */
+  g = Gread_disdro_mmap(infile, NULL);
+  if (g != NULL) return g;
+
   fp = fopen(infile, "r");
   if(fp==NULL)
 	{
@@ -394,8 +1209,8 @@ Gauge *Gread_disdro_gauge(char *infile)
 				 &g->h.range, &g->h.azimuth);
 
   g->h.name = (char *) strdup(name);
-  g->h.type = (char *) strdup(type);
-  g->h.network = (char *) strdup(network);
+  g->h.type = Gintern(type);
+  g->h.network = Gintern(network);
 
   n = 0;
   while(fscanf(fp, "%d %d %2d%2d\n", &yy, &jday, &hh, &mm) != EOF)
@@ -406,6 +1221,7 @@ Gauge *Gread_disdro_gauge(char *infile)
 		g->record[n].time.hour   = hh;
 		g->record[n].time.minute = mm;
 		g->record[n].time.sec    = 0.0;
+		g->record[n].time.key    = Gmake_time_key(yy, jday, hh, mm, 0);
 		for (k=0; k<20; k++)
 		{
 		  if (fscanf(fp, "%d", &val) == EOF)
@@ -414,62 +1230,73 @@ Gauge *Gread_disdro_gauge(char *infile)
 		}
 	
 		n++;
-		if (n >= g->h.nobs)
-	    g = copy_to_larger_obs(g, g->h.nobs + maxobs);
+		if (n >= g->h.nobs && Gresize_gauge(g, 2*g->h.nobs) == NULL) break;
   }
   fclose(fp);
-  g->h.nobs = n;
+  if (Gresize_gauge(g, n) == NULL) g->h.nobs = n;
   return g;
 }
 
 /*************************************************************/
 /*                                                           */
-/*                 Gconstruct_gauge_complex                  */
+/*                   start_gauge_complex                     */
 /*                                                           */
 /*************************************************************/
-Gauge_complex *Gconstruct_gauge_complex(int nfile, char **file,
-																				int instrument)
+static Gauge_network *new_complex_network(Gauge_complex *gc, int ngauge)
 {
-	/* Reads raingauge (disdrometer) data from all input data files into
-		 a GSL Gauge_complex structure.
+	Gauge_network *gnet;
 
-		 Checks that all included gauges belong to the same radar site.
-		 NOTE: A GSL 'Gauge_complex' structure contains any amount of
-		 data from any number of raingauges from any number of raingauge
-		 networks located at ONE radar site. Ditto for disdrometer data.
+	if (gc->arena == NULL) return Gnew_gauge_network(ngauge);
+	gnet = (Gauge_network *)Garena_alloc(gc->arena, sizeof(Gauge_network));
+	if (gnet == NULL) return NULL;
+	gnet->arena = gc->arena;
+	gnet->gauge = (Gauge **)Garena_alloc(gc->arena, (ngauge+1)*sizeof(Gauge *));
+	if (gnet->gauge == NULL) return NULL;
+	return gnet;
+}
 
-		 Returns: gauge_complex if success.
-		          NULL if fails.
-  */
-	char *radarSite;
-	int j;
+static Gauge_complex *start_gauge_complex(int arena)
+{
+	/* An empty gauge_complex, ready for add_gauge_to_complex; with an
+		 arena of its own if 'arena' is nonzero. */
 	Gauge_complex *gcomplex;
-	Gauge_network *gnet;
-	Gauge *g;
-	
+
 	/* Create and initialize the GSL gauge_complex structure. */
-	gcomplex = (Gauge_complex *)Gnew_gauge_complex(MAX_GAUGE_NETWORKS);
+	if (arena)
+	  gcomplex = Gnew_gauge_complex_arena(MAX_GAUGE_NETWORKS);
+	else
+	  gcomplex = (Gauge_complex *)Gnew_gauge_complex(MAX_GAUGE_NETWORKS);
 	if (gcomplex == NULL)
 	{
 		fprintf(stderr, "**Error allocating gauge_complex.\n");
 		return(NULL);
 	}
-	gcomplex->h.radarSite = (char *) strdup("N/A");
+	gcomplex->h.radarSite = Gintern("N/A");
 	gcomplex->h.nnet = 0;
-	
-	/* Loop to read each raingauge or disdrometer data file into the GSL
-		 gauge_complex. */
-	for (j=0; j<nfile; j++)
-	{
-		fprintf(stderr, "Reading gauge file: %s\n", file[j]);
-		if (instrument == RAINGAUGE) g = (Gauge *)Gread_gmin(file[j]);
-		else g = (Gauge *)Gread_disdro_gauge(file[j]);
-		if (g == NULL)
-		{
-		  fprintf(stderr, "** Error reading gauge file: %s\n", file[j]);
-			exit(0);
-			continue;
-		}
+	return(gcomplex);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                   add_gauge_to_complex                    */
+/*                                                           */
+/*************************************************************/
+static int add_gauge_to_complex(Gauge_complex *gcomplex, Gauge *g, int j)
+{
+	/* Adds gauge 'g', read from input file number 'j', to its network
+		 in the gauge_complex, creating the network if needed.
+
+		 Returns: OK, if success.  The gauge_complex now owns 'g' (or, if
+		              it has an arena that 'g' is not in, a copy of 'g'
+		              and 'g' is freed).
+		          ABORT, if the gauge does not fit or does not belong in
+		                 this gauge_complex.  The gauge_complex has then
+		                 been freed; 'g' has not.
+	*/
+	char *radarSite;
+	Gauge_network *gnet;
+	Gauge *ag;
+
 		/* Find the network to which this gauge belongs in the gauge_complex
 			 structure. */
 		gnet = (Gauge_network *)find_network_in_gauge_complex(gcomplex,
@@ -482,27 +1309,33 @@ Gauge_complex *Gconstruct_gauge_complex(int nfile, char **file,
 				fprintf(stderr, "*** Exceeded max number of gauge networks: %d\n",
 								MAX_GAUGE_NETWORKS);
 				Gfree_gauge_complex(gcomplex);
-				return(NULL);
+				return(ABORT);
 			}
 			fprintf(stderr, "*** Creating GSL network: %s\n", g->h.network);
-			gnet = (Gauge_network *)Gnew_gauge_network(MAX_NETWORK_GAUGES);
-			gnet->h.name = g->h.network;
-			gnet->h.type =  g->h.type;
+			gnet = new_complex_network(gcomplex, MAX_NETWORK_GAUGES);
+			if (gnet == NULL)
+			{
+				Gfree_gauge_complex(gcomplex);
+				return(ABORT);
+			}
+			gnet->h.name = Gintern(g->h.network);
+			gnet->h.type = Gintern(g->h.type);
 			gnet->h.ngauge = 0;
 			gcomplex->net[gcomplex->h.nnet] = gnet; /* Add net to complex */ 
 			gcomplex->h.nnet++;
 			/* Retrieve from a database file the name of the radar site to
 				 which this new gauge_network is attached. Then check that
 				 this gauge_network belongs in this gauge_complex. */
-			radarSite = (char *) strdup(find_gauge_radarSite(gnet->h.name));
+			radarSite = find_gauge_radarSite(gnet->h.name);
 			if (strcmp(radarSite, "???") == 0)
 			{
 				Gfree_gauge_complex(gcomplex);
-				return(NULL);
+				return(ABORT);
 			}
 			
 			/* Does this gauge's radar site match this complex's radar site? */
-			if (strcmp(radarSite, gcomplex->h.radarSite) != 0)
+			radarSite = Gintern(radarSite);
+			if (radarSite != gcomplex->h.radarSite)
 			{
 			  if (j == 0)  /* First gauge file establishes radar site. */
 				  gcomplex->h.radarSite = radarSite;
@@ -513,7 +1346,7 @@ Gauge_complex *Gconstruct_gauge_complex(int nfile, char **file,
 					fprintf(stderr, "does not belong to this gauge_complex from : %s\n",
 									gcomplex->h.radarSite);
 					Gfree_gauge_complex(gcomplex);
-					return(NULL);
+					return(ABORT);
 				}
 			} /* end if (strcmp(radarSite, ... */
 		} /* end if (gnet == NULL) */
@@ -523,15 +1356,198 @@ Gauge_complex *Gconstruct_gauge_complex(int nfile, char **file,
 			fprintf(stderr, "*** Exceeded max number of gauges: %d in network: %s\n",
 							MAX_NETWORK_GAUGES, gnet->h.name);
 			Gfree_gauge_complex(gcomplex);
-			return(NULL);
+			return(ABORT);
+		}
+		if (gcomplex->arena != NULL && g->arena != gcomplex->arena)
+		{
+			/* Move the gauge into the arena. */
+			ag = Garena_copy_gauge(gcomplex->arena, g);
+			if (ag == NULL)
+			{
+				Gfree_gauge_complex(gcomplex);
+				return(ABORT);
+			}
+			Gfree_gauge(g);
+			g = ag;
 		}
 		gnet->gauge[gnet->h.ngauge] = g; /* Add gauge to network. */
 		gnet->h.ngauge++;
+		/* Keep the lookup tables current, so that readers of a finished
+			 complex never have to update them. */
+		index_gauge_complex(gcomplex);
+		Gindex_gauge_network(gnet);
+		return(OK);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                 Gconstruct_gauge_complex                  */
+/*                                                           */
+/*************************************************************/
+static Gauge_complex *construct_complex(int nfile, char **file,
+										int instrument, int arena)
+{
+	/* Gconstruct_gauge_complex; in an arena complex if 'arena' is
+		 nonzero. */
+	int j, in_arena;
+	Gauge_complex *gcomplex;
+	Gauge *g;
+	
+	gcomplex = start_gauge_complex(arena);
+	if (gcomplex == NULL) return(NULL);
+	
+	/* Loop to read each raingauge or disdrometer data file into the GSL
+		 gauge_complex. */
+	for (j=0; j<nfile; j++)
+	{
+		fprintf(stderr, "Reading gauge file: %s\n", file[j]);
+		/* An arena complex has its gauges parsed straight into the arena;
+			 only files that cannot be mapped are read and then copied. */
+		g = NULL;
+		if (gcomplex->arena != NULL)
+		{
+			if (instrument == RAINGAUGE) g = Gread_gmin_mmap(file[j], gcomplex->arena);
+			else g = Gread_disdro_mmap(file[j], gcomplex->arena);
+		}
+		if (g == NULL)
+		{
+			if (instrument == RAINGAUGE) g = (Gauge *)Gread_gmin(file[j]);
+			else g = (Gauge *)Gread_disdro_gauge(file[j]);
+		}
+		if (g == NULL)
+		{
+		  fprintf(stderr, "** Error reading gauge file: %s\n", file[j]);
+			exit(0);
+			continue;
+		}
+		in_arena = (g->arena != NULL);
+		if (add_gauge_to_complex(gcomplex, g, j) != OK)
+		{
+			/* An arena gauge went with the complex. */
+			if (!in_arena) Gfree_gauge(g);
+			return(NULL);
+		}
 	} /* for (j=0; j<nfile; j++) */
 
 	return(gcomplex);
 }
 
+Gauge_complex *Gconstruct_gauge_complex(int nfile, char **file,
+																				int instrument)
+{
+	/* Reads raingauge (disdrometer) data from all input data files into
+		 a GSL Gauge_complex structure.
+
+		 Checks that all included gauges belong to the same radar site.
+		 NOTE: A GSL 'Gauge_complex' structure contains any amount of
+		 data from any number of raingauges from any number of raingauge
+		 networks located at ONE radar site. Ditto for disdrometer data.
+
+		 Returns: gauge_complex if success.
+		          NULL if fails.
+  */
+	return(construct_complex(nfile, file, instrument, 0));
+}
+
+typedef struct {
+	char  **file;
+	int     instrument;
+	Gauge **g;         /* g[j] is read from file[j]. */
+} Gauge_file_jobs;
+
+static void read_gauge_file(int j, void *arg)
+{
+	Gauge_file_jobs *jobs = (Gauge_file_jobs *)arg;
+
+	fprintf(stderr, "Reading gauge file: %s\n", jobs->file[j]);
+	if (jobs->instrument == RAINGAUGE) jobs->g[j] = Gread_gmin(jobs->file[j]);
+	else jobs->g[j] = Gread_disdro_gauge(jobs->file[j]);
+}
+
+/*************************************************************/
+/*                                                           */
+/*             Gconstruct_gauge_complex_parallel             */
+/*                                                           */
+/*************************************************************/
+static Gauge_complex *construct_complex_parallel(int nfile, char **file,
+												 int instrument, int nthread,
+												 int arena)
+{
+	/* Gconstruct_gauge_complex_parallel; in an arena complex if 'arena'
+		 is nonzero.  An arena is not shared between threads, so the
+		 threads parse into malloc'ed gauges, which are copied into the
+		 arena as they are added. */
+	int j, k;
+	Gauge_complex *gcomplex;
+	Gauge_file_jobs jobs;
+
+	if (nfile <= 0 || nthread == 1)
+		return(construct_complex(nfile, file, instrument, arena));
+
+	jobs.file = file;
+	jobs.instrument = instrument;
+	jobs.g = (Gauge **)calloc(nfile, sizeof(Gauge *));
+	if (jobs.g == NULL)
+	{
+		perror("Gconstruct_gauge_complex_parallel");
+		return(NULL);
+	}
+	Gparallel_for(nfile, nthread, read_gauge_file, &jobs);
+
+	gcomplex = start_gauge_complex(arena);
+	for (j=0; gcomplex != NULL && j<nfile; j++)
+	{
+		if (jobs.g[j] == NULL)
+		{
+		  fprintf(stderr, "** Error reading gauge file: %s\n", file[j]);
+			exit(0);
+		}
+		if (add_gauge_to_complex(gcomplex, jobs.g[j], j) != OK)
+		{
+			for (k=j; k<nfile; k++) Gfree_gauge(jobs.g[k]);
+			gcomplex = NULL;
+		}
+	}
+	free(jobs.g);
+	return(gcomplex);
+}
+
+Gauge_complex *Gconstruct_gauge_complex_parallel(int nfile, char **file,
+												 int instrument, int nthread)
+{
+	/* Same as Gconstruct_gauge_complex, but the input files are parsed
+		 concurrently by up to 'nthread' threads (nthread <= 0: one per
+		 processor; see Gparallel_for).  The gauges are then added to the
+		 gauge_complex one by one in file order, so the networks, their
+		 gauge order and the radar site check come out exactly as they
+		 do from Gconstruct_gauge_complex.
+
+		 Returns: gauge_complex if success.
+		          NULL if fails.
+  */
+	return(construct_complex_parallel(nfile, file, instrument, nthread, 0));
+}
+
+/*************************************************************/
+/*                                                           */
+/*               Gconstruct_gauge_complex_arena              */
+/*                                                           */
+/*************************************************************/
+Gauge_complex *Gconstruct_gauge_complex_arena(int nfile, char **file,
+											  int instrument, int nthread)
+{
+	/* Gconstruct_gauge_complex_parallel, building an arena complex (see
+		 Gnew_gauge_complex_arena) that Gfree_gauge_complex releases at
+		 once.  With nthread == 1 the files are parsed straight into the
+		 arena; otherwise the gauges are parsed by the threads and copied
+		 in.
+
+		 Returns: gauge_complex if success.
+		          NULL if fails.
+  */
+	return(construct_complex_parallel(nfile, file, instrument, nthread, 1));
+}
+
 /*************************************************************/
 /*                                                           */
 /*                 Gcopy_gauge                               */
@@ -540,6 +1556,7 @@ Gauge_complex *Gconstruct_gauge_complex(int nfile, char **file,
 Gauge *Gcopy_gauge(Gauge *g)
 {
   Gauge *newg;
+  int j;
 
   if (g == NULL) return NULL;
   newg = (Gauge *)calloc(1, sizeof(Gauge));
@@ -548,11 +1565,15 @@ Gauge *Gcopy_gauge(Gauge *g)
 	return NULL;
   }
   newg->h = g->h;
-  /* Explicitly, copy some strings.  Using a copy of the pointer
-   * seems ok, but, this will give a true copy.
+  /* Explicitly, copy the name.  The other strings are interned;
+   * interning them again covers headers filled in by hand.
    */
-  newg->h.name = (char *) strdup(newg->h.name);
-  newg->h.type = (char *) strdup(newg->h.type);
+  if (newg->h.name)       newg->h.name       = (char *) strdup(newg->h.name);
+  newg->h.network    = Gintern(newg->h.network);
+  newg->h.gv_site    = Gintern(newg->h.gv_site);
+  newg->h.product_id = Gintern(newg->h.product_id);
+  newg->h.type       = Gintern(newg->h.type);
+  newg->h.radar      = Gintern(newg->h.radar);
 
   /* Allocate the space for the observations. */
   newg->record = (Gauge_record *)calloc(newg->h.nobs, sizeof(Gauge_record));
@@ -562,6 +1583,24 @@ Gauge *Gcopy_gauge(Gauge *g)
   }
 
   memcpy(newg->record, g->record, newg->h.nobs * sizeof(Gauge_record));
+
+  /* The values too, into one block as Gnew_gauge lays them out, so
+   * the copy can be sorted and freed independently of 'g'.
+   */
+  if (newg->h.nobs > 0) {
+	newg->record->value = (float *)malloc(newg->h.nobs*newg->h.nbin*sizeof(float));
+	if (newg->record->value == NULL) {
+	  perror("Gcopy_gauge, ->record->value");
+	  free(newg->record);
+	  free(newg);
+	  return NULL;
+	}
+	for (j=0; j<newg->h.nobs; j++) {
+	  newg->record[j].value = newg->record->value + j*newg->h.nbin;
+	  memcpy(newg->record[j].value, g->record[j].value,
+			 newg->h.nbin*sizeof(float));
+	}
+  }
   return newg;
 }
 
@@ -573,36 +1612,138 @@ static int obs_sort_compare_by_time(Gauge_record *r1, Gauge_record *r2)
    if (r1 == NULL) return 1;
    if (r2 == NULL) return -1;
 
-   /* Compare year value */
-   if (r1->time.year < r2->time.year) return -1;
-   if (r1->time.year > r2->time.year) return 1;
+   /* The packed key orders records as year, jday, ..., sec did. */
+   if (r1->time.key < r2->time.key) return -1;
+   if (r1->time.key > r2->time.key) return 1;
+
+   return 0;
+   }
 
-   /* Compare jday value */
-   if (r1->time.jday < r2->time.jday) return -1;
-   if (r1->time.jday > r2->time.jday) return 1;
+static int same_network_name(int j, void *arg)
+{
+	Gauge_complex *gc = ((void **)arg)[0];
+	char *netName     = ((void **)arg)[1];
+	return Gsame_string(gc->net[j]->h.name, netName);
+}
 
-   /* Compare month value */
-   if (r1->time.month < r2->time.month) return -1;
-   if (r1->time.month > r2->time.month) return 1;
+static int same_gauge_number(int j, void *arg)
+{
+	Gauge_network *gnet = ((void **)arg)[0];
+	int *number         = ((void **)arg)[1];
+	return gnet->gauge[j]->h.number == *number;
+}
 
-   /* Compare day value */
-   if (r1->time.day < r2->time.day) return -1;
-   if (r1->time.day > r2->time.day) return 1;
+static int same_gauge_name(int j, void *arg)
+{
+	Gauge_network *gnet = ((void **)arg)[0];
+	char *name          = ((void **)arg)[1];
+	return (gnet->gauge[j]->h.name != NULL &&
+			strcmp(gnet->gauge[j]->h.name, name) == 0);
+}
 
-   /* Compare hour value */
-   if (r1->time.hour < r2->time.hour) return -1;
-   if (r1->time.hour > r2->time.hour) return 1;
+/*************************************************************/
+/*                                                           */
+/*                     index_gauge_complex                   */
+/*                                                           */
+/*************************************************************/
+static int index_gauge_complex(Gauge_complex *gc)
+{
+	/* Brings gc->by_name up to date with net[0..nnet-1].  Networks
+		 appended since the last call are added; if networks were removed
+		 the table is rebuilt.  The first network of a given name wins.
+	*/
+	void *arg[2];
+	int j;
 
-   /* Compare minute value */
-   if (r1->time.minute < r2->time.minute) return -1;
-   if (r1->time.minute > r2->time.minute) return 1;
-   
-   /* Compare second value */
-   if (r1->time.sec < r2->time.sec) return -1;
-   if (r1->time.sec > r2->time.sec) return 1;
+	if (gc->by_name == NULL || gc->nindexed > gc->h.nnet)
+	{
+		Gfree_index(gc->by_name);
+		gc->by_name = Gnew_index(MAX_GAUGE_NETWORKS);
+		gc->nindexed = 0;
+		if (gc->by_name == NULL) return(ABORT);
+	}
+	arg[0] = gc;
+	for (j=gc->nindexed; j<gc->h.nnet; j++)
+	{
+		arg[1] = gc->net[j]->h.name;
+		if (gc->net[j]->h.name == NULL) continue;
+		if (Gindex_find(gc->by_name, Ghash_string(arg[1]),
+						same_network_name, arg) >= 0) continue;
+		if (Gindex_add(gc->by_name, Ghash_string(arg[1]), j) != OK)
+			return(ABORT);
+	}
+	gc->nindexed = gc->h.nnet;
+	return(OK);
+}
 
-   return 0;
-   }
+/*************************************************************/
+/*                                                           */
+/*                    Gindex_gauge_network                   */
+/*                                                           */
+/*************************************************************/
+int Gindex_gauge_network(Gauge_network *gnet)
+{
+	/* Same as index_gauge_complex, for the gauges of a network. */
+	void *arg[2];
+	int j;
+
+	if (gnet->by_number == NULL || gnet->by_name == NULL ||
+		gnet->nindexed > gnet->h.ngauge)
+	{
+		Gfree_index(gnet->by_number);
+		Gfree_index(gnet->by_name);
+		gnet->by_number = Gnew_index(gnet->h.ngauge);
+		gnet->by_name   = Gnew_index(gnet->h.ngauge);
+		gnet->nindexed  = 0;
+		if (gnet->by_number == NULL || gnet->by_name == NULL) return(ABORT);
+	}
+	arg[0] = gnet;
+	for (j=gnet->nindexed; j<gnet->h.ngauge; j++)
+	{
+		if (gnet->gauge[j] == NULL) continue;
+		arg[1] = &gnet->gauge[j]->h.number;
+		if (Gindex_find(gnet->by_number, Ghash_int(gnet->gauge[j]->h.number),
+						same_gauge_number, arg) < 0 &&
+			Gindex_add(gnet->by_number, Ghash_int(gnet->gauge[j]->h.number),
+					   j) != OK)
+			return(ABORT);
+		arg[1] = gnet->gauge[j]->h.name;
+		if (arg[1] == NULL) continue;
+		if (Gindex_find(gnet->by_name, Ghash_string(arg[1]),
+						same_gauge_name, arg) < 0 &&
+			Gindex_add(gnet->by_name, Ghash_string(arg[1]), j) != OK)
+			return(ABORT);
+	}
+	gnet->nindexed = gnet->h.ngauge;
+	return(OK);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                    Gindex_gauge_complex                   */
+/*                                                           */
+/*************************************************************/
+int Gindex_gauge_complex(Gauge_complex *gc)
+{
+	/* Brings all the lookup tables of 'gc' up to date.  A lookup
+		 (find_network_in_gauge_complex, Gfind_gauge_by_number ...) only
+		 writes to the tables when they are behind, so after this call
+		 any number of threads may look up at once -- until the complex
+		 is changed again.  The readers in this library call it on the
+		 complexes they return.
+
+		 Returns: OK, if success.
+		          ABORT, if out of memory.
+	*/
+	int j, status;
+
+	if (gc == NULL) return(OK);
+	status = index_gauge_complex(gc);
+	for (j=0; j<gc->h.nnet; j++)
+		if (gc->net[j] != NULL && Gindex_gauge_network(gc->net[j]) != OK)
+			status = ABORT;
+	return(status);
+}
 
 /*************************************************************/
 /*                                                           */
@@ -617,13 +1758,80 @@ Gauge_network *find_network_in_gauge_complex(Gauge_complex *gc,
 		   network, if found in the gauge_complex.
 			 NULL, if not found.
 	*/
+	void *arg[2];
 	int j;
 	
-	for (j=0; j<gc->h.nnet; j++)
-		if (strcmp(netName, gc->net[j]->h.name) == 0)
-		  return(gc->net[j]);
+	if (gc == NULL || netName == NULL) return(NULL);
+	if (gc->nindexed != gc->h.nnet && index_gauge_complex(gc) != OK)
+	{
+		/* Out of memory; fall back to the linear search. */
+		for (j=0; j<gc->h.nnet; j++)
+			if (Gsame_string(netName, gc->net[j]->h.name))
+			  return(gc->net[j]);
+		return(NULL);
+	}
+	arg[0] = gc;
+	arg[1] = netName;
+	j = Gindex_find(gc->by_name, Ghash_string(netName), same_network_name, arg);
 	/* No such network name found. */
-	return(NULL);
+	if (j < 0) return(NULL);
+	return(gc->net[j]);
+}
+
+/*************************************************************/
+/*                                                           */
+/*            Gfind_gauge_by_number / Gfind_gauge_by_name    */
+/*                                                           */
+/*************************************************************/
+Gauge *Gfind_gauge_by_number(Gauge_network *gnet, int number)
+{
+	/* Returns the (first) gauge with h.number == 'number' in the
+		 network, or NULL.  Constant time, via the network's tables. */
+	void *arg[2];
+	int j;
+
+	if (gnet == NULL) return(NULL);
+	if (gnet->nindexed != gnet->h.ngauge || gnet->by_number == NULL)
+		if (Gindex_gauge_network(gnet) != OK) return(NULL);
+	arg[0] = gnet;
+	arg[1] = &number;
+	j = Gindex_find(gnet->by_number, Ghash_int(number), same_gauge_number, arg);
+	return((j < 0) ? NULL : gnet->gauge[j]);
+}
+
+Gauge *Gfind_gauge_by_name(Gauge_network *gnet, char *name)
+{
+	/* Returns the (first) gauge named 'name' in the network, or NULL. */
+	void *arg[2];
+	int j;
+
+	if (gnet == NULL || name == NULL) return(NULL);
+	if (gnet->nindexed != gnet->h.ngauge || gnet->by_name == NULL)
+		if (Gindex_gauge_network(gnet) != OK) return(NULL);
+	arg[0] = gnet;
+	arg[1] = name;
+	j = Gindex_find(gnet->by_name, Ghash_string(name), same_gauge_name, arg);
+	return((j < 0) ? NULL : gnet->gauge[j]);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                   Gfind_gauge_in_complex                  */
+/*                                                           */
+/*************************************************************/
+Gauge *Gfind_gauge_in_complex(Gauge_complex *gc, char *netName, int number)
+{
+	/* Gauge 'number' of network 'netName', or NULL. */
+	return(Gfind_gauge_by_number(find_network_in_gauge_complex(gc, netName),
+								 number));
+}
+
+Gauge *Gfind_gauge_in_complex_by_name(Gauge_complex *gc, char *netName,
+									  char *name)
+{
+	/* Gauge 'name' of network 'netName', or NULL. */
+	return(Gfind_gauge_by_name(find_network_in_gauge_complex(gc, netName),
+							   name));
 }
 
 /*************************************************************/
@@ -635,39 +1843,199 @@ char *find_gauge_radarSite(char *netName)
 {
 	/* Given the name of a gauge network, find the radar site to which
 		 the network belongs. This info is presently contained only in 
-		 Fisher's database file 'radar.dat'.
+		 Fisher's database file 'radar.dat' (see Gset_radar_catalog_path),
+		 which is read once and then looked up by network name.
+
+		 Returns: the radar site, or "???" if not found.  Do not modify
+		          or free the string.
   */
-	int status=EOF;
-	FILE *dbfile;
-	char line[1000];
-	static char radarSite_from_dbfile[6];
-	char netName_from_dbfile[6];
-	
-	dbfile = fopen("/usr/local/trmm/GVBOX/data/sitelist/radar.dat", "r");
-	if (dbfile == NULL)
-	{
-		fprintf(stderr, "Error opening database file: %s\n", "radar.dat");
-		goto quit;
-	}
-	while (fgets(line, sizeof(line), dbfile) != NULL) {
-	  /* The first 2 lines contain header info. Skip past comments. */
-	  if (line[0] == '#') continue;
-	  status = sscanf(line, "%*s %3s %4s %*s %*s", netName_from_dbfile,
-					  radarSite_from_dbfile);
-	  if (strcmp(netName_from_dbfile, netName) == 0) break;
-	}
-	while (status != EOF);
+	static char not_found[] = "???";
+	Gradar_catalog *cat;
+	Gradar_entry *e;
 
- quit:
-	fclose(dbfile);
-	if (status == EOF)
+	cat = Gradar_catalog_for(NULL);
+	e = Gfind_radar_by_network(cat, netName);
+	if (e == NULL)
 	{
 		fprintf(stderr, "** Gauge network: %s not found in database file: %s\n",
 						netName, "radar.dat");
-	  strcpy(radarSite_from_dbfile, "???");
+		return(not_found);
+	}
+	return(e->radar);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                   Gsort_gauge_order                       */
+/*                                                           */
+/*************************************************************/
+static int gauge_is_sorted(Gauge *g)
+{
+  int j;
+
+  for (j=1; j<g->h.nobs; j++)
+	if (obs_sort_compare_by_time(&g->record[j-1], &g->record[j]) > 0)
+	  return 0;
+  return 1;
+}
+
+int Gsort_gauge_order(Gauge *g, int *order)
+{
+  /* Fills order[0..nobs-1] with record indices in time order, leaving
+	 'g' untouched: record[order[0]] is the earliest.  Records with
+	 equal times keep their relative order.  Uses the time keys (see
+	 Gcheck_gauge_time_keys).
+
+	 Least significant digit radix sort of the keys, 8 bits a pass.
+	 Only the bytes in which the keys actually differ are sorted on;
+	 a day of one minute records needs three passes.
+
+	 Returns: OK, if success.
+	          ABORT, if out of memory.
+  */
+  unsigned long long *buf, *key, *key2, *kt, range;
+  int *scratch, *idx, *idx2, *it;
+  int count[256];
+  Gtime_key kmin, kmax;
+  int j, n, b, shift, sum, c;
+
+  if (g == NULL || order == NULL) return ABORT;
+  Gcheck_gauge_time_keys(g);
+  n = g->h.nobs;
+  for (j=0; j<n; j++) order[j] = j;
+  if (n < 2 || gauge_is_sorted(g)) return OK;
+
+  kmin = kmax = g->record[0].time.key;
+  for (j=1; j<n; j++) {
+	if (g->record[j].time.key < kmin) kmin = g->record[j].time.key;
+	if (g->record[j].time.key > kmax) kmax = g->record[j].time.key;
+  }
+  range = (unsigned long long)(kmax - kmin);
+
+  buf     = (unsigned long long *)malloc(2*n*sizeof(unsigned long long));
+  scratch = (int *)malloc(n*sizeof(int));
+  if (buf == NULL || scratch == NULL) {
+	perror("Gsort_gauge_order");
+	if (buf) free(buf);
+	if (scratch) free(scratch);
+	return ABORT;
+  }
+  key  = buf;
+  key2 = buf + n;
+  idx  = scratch;
+  idx2 = order;
+  for (j=0; j<n; j++) {
+	key[j] = (unsigned long long)(g->record[j].time.key - kmin);
+	idx[j] = j;
+  }
+
+  for (shift=0; shift<64 && (range >> shift) != 0; shift += 8) {
+	memset(count, 0, sizeof(count));
+	for (j=0; j<n; j++) count[(key[j] >> shift) & 0xff]++;
+	if (count[key[0] >> shift & 0xff] == n) continue; /* All the same. */
+	for (sum=0, b=0; b<256; b++) {
+	  c = count[b];
+	  count[b] = sum;
+	  sum += c;
+	}
+	for (j=0; j<n; j++) {
+	  c = count[(key[j] >> shift) & 0xff]++;
+	  key2[c] = key[j];
+	  idx2[c] = idx[j];
 	}
+	kt = key; key = key2; key2 = kt;
+	it = idx; idx = idx2; idx2 = it;
+  }
+
+  /* After an odd number of passes the result is in 'scratch'. */
+  if (idx != order) memcpy(order, idx, n*sizeof(int));
+  free(buf);
+  free(scratch);
+  return OK;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                  Gsort_gauge_in_place                     */
+/*                                                           */
+/*************************************************************/
+static int contiguous_values(Gauge *g)
+{
+  /* Are the values laid out as Gnew_gauge does it? */
+  int j;
+
+  for (j=0; j<g->h.nobs; j++)
+	if (g->record[j].value != g->record->value + j*g->h.nbin)
+	  return 0;
+  return 1;
+}
+
+int Gsort_gauge_in_place(Gauge *g)
+{
+  /* Sorts the records of 'g' by time (see Gsort_gauge_order) without
+	 copying the gauge.  When the values are laid out as Gnew_gauge
+	 does it (one block, nbin floats per record) they are moved with
+	 their records and record[j].value keeps pointing at the j-th
+	 chunk, so Gfree_gauge still works.  Otherwise only the records,
+	 value pointers and all, are moved.
+
+	 Returns: OK, if success.
+	          ABORT, if out of memory.
+  */
+  Gauge_record r;
+  float *base, *chunk = NULL;
+  int *order;
+  int i, j, k, n, nbin, move_values;
+
+  if (g == NULL) return ABORT;
+  Gcheck_gauge_time_keys(g);
+  n = g->h.nobs;
+  if (n < 2 || gauge_is_sorted(g)) return OK;
+
+  nbin = g->h.nbin;
+  base = g->record->value;
+  move_values = contiguous_values(g);
+  order = (int *)malloc(n*sizeof(int));
+  if (move_values)
+	chunk = (float *)malloc(nbin*sizeof(float));
+  if (order == NULL || (move_values && chunk == NULL)) {
+	perror("Gsort_gauge_in_place");
+	if (order) free(order);
+	if (chunk) free(chunk);
+	return ABORT;
+  }
+  if (Gsort_gauge_order(g, order) != OK) {
+	free(order);
+	if (chunk) free(chunk);
+	return ABORT;
+  }
 
-	return(radarSite_from_dbfile);
+  /* Apply the permutation one cycle at a time: slot i receives record
+   * order[i].  Visited slots are marked by order[i] = i.
+   */
+  for (i=0; i<n; i++) {
+	if (order[i] == i) continue;
+	r = g->record[i];
+	if (move_values) memcpy(chunk, r.value, nbin*sizeof(float));
+	for (j=i; order[j] != i; j=k) {
+	  k = order[j];
+	  g->record[j] = g->record[k];
+	  if (move_values) {
+		g->record[j].value = base + j*nbin;
+		memcpy(g->record[j].value, g->record[k].value, nbin*sizeof(float));
+	  }
+	  order[j] = j;
+	}
+	g->record[j] = r;
+	if (move_values) {
+	  g->record[j].value = base + j*nbin;
+	  memcpy(g->record[j].value, chunk, nbin*sizeof(float));
+	}
+	order[j] = j;
+  }
+  free(order);
+  if (chunk) free(chunk);
+  return OK;
 }
 
 /*************************************************************/
@@ -677,69 +2045,273 @@ char *find_gauge_radarSite(char *netName)
 /*************************************************************/
 Gauge *Gsort_gauge_by_time(Gauge *g)
 {
-  /* Allocates memory via Gcopy_gauge */
+  /* Returns a sorted copy of 'g'; 'g' is not changed.  Allocates
+   * memory via Gcopy_gauge.  See Gsort_gauge_in_place to sort
+   * without the copy.
+   */
   Gauge *newg;
   newg = Gcopy_gauge(g);
   if (newg == NULL) return newg;
+  /* Callers of this function may predate the time keys. */
+  Gset_gauge_time_keys(newg);
 
-  qsort((void *)newg->record, newg->h.nobs, sizeof(Gauge_record),
-		(int (*)(const void *, const void *))obs_sort_compare_by_time);
-
+  if (Gsort_gauge_in_place(newg) != OK) {
+	Gfree_gauge(newg);
+	return NULL;
+  }
   return newg;
 }
   
 /*************************************************************/
 /*                                                           */
-/*                 Gsort_network_by_time                     */
+/*                    Gnew_network_merge                     */
 /*                                                           */
 /*************************************************************/
-Gauge_measurement_at_time *Gsort_network_by_time(Gauge_network *gnet)
+/* A k-way merge of the gauges of a network.  The heap holds one entry
+ * per gauge that has records left, ordered by the time key of its
+ * next record.  Each row pops every gauge whose next record is at the
+ * earliest time, so a row costs O(m log k) for m gauges reporting at
+ * that time out of k.
+ */
+static Gauge_record *merge_head(Gnetwork_merge *m, int i)
 {
-  /*
-   * A. Sort each gauge by time.
-   * B. Merge gauges by time.
-   */
-  Gauge_measurement_at_time *gmat;
-  Gauge **sorted_gauges;
-  Gauge *g;
-  int *index, done;
+  Gauge *g = m->gnet->gauge[i];
+  int j = m->cursor[i];
 
-  int i;
+  return &g->record[m->order[i] ? m->order[i][j] : j];
+}
+
+static Gtime_key merge_key(Gnetwork_merge *m, int i)
+{
+  return merge_head(m, i)->time.key;
+}
+
+static void merge_sift_down(Gnetwork_merge *m, int k)
+{
+  int c, top = m->heap[k];
+  Gtime_key key = merge_key(m, top);
+
+  while ((c = 2*k+1) < m->nheap) {
+	if (c+1 < m->nheap && merge_key(m, m->heap[c+1]) < merge_key(m, m->heap[c]))
+	  c++;
+	if (merge_key(m, m->heap[c]) >= key) break;
+	m->heap[k] = m->heap[c];
+	k = c;
+  }
+  m->heap[k] = top;
+}
+
+static void merge_sift_up(Gnetwork_merge *m, int i)
+{
+  /* Adds gauge i to the heap. */
+  int k, parent;
+  Gtime_key key = merge_key(m, i);
+
+  for (k = m->nheap++; k > 0; k = parent) {
+	parent = (k-1)/2;
+	if (merge_key(m, m->heap[parent]) <= key) break;
+	m->heap[k] = m->heap[parent];
+  }
+  m->heap[k] = i;
+}
+
+Gnetwork_merge *Gnew_network_merge(Gauge_network *gnet)
+{
+  /* Starts a time ordered walk through all records of 'gnet'.  Each
+	 call to Gnext_network_merge then returns one time step.  Neither
+	 the network nor its gauges are changed or copied; unsorted gauges
+	 are visited through an index permutation.  Keys left unset are
+	 filled in (see Gcheck_gauge_time_keys).
+
+	 Returns: merge, if success.  Free with Gfree_network_merge.
+	          NULL, otherwise.
+  */
+  Gnetwork_merge *m;
+  Gauge *g;
+  int i, k, n;
 
   if (gnet == NULL) return NULL;
+  n = gnet->h.ngauge;
+  m = (Gnetwork_merge *)calloc(1, sizeof(Gnetwork_merge));
+  if (m == NULL) {
+	perror("Gnew_network_merge");
+	return NULL;
+  }
+  m->gnet   = gnet;
+  m->order  = (int **)calloc(n+1, sizeof(int *));
+  m->cursor = (int *)calloc(n+1, sizeof(int));
+  m->heap   = (int *)calloc(n+1, sizeof(int));
+  m->member = (int *)calloc(n+1, sizeof(int));
+  m->rec    = (Gauge_record **)calloc(n+1, sizeof(Gauge_record *));
+  if (m->order == NULL || m->cursor == NULL || m->heap == NULL ||
+	  m->member == NULL || m->rec == NULL) {
+	perror("Gnew_network_merge");
+	Gfree_network_merge(m);
+	return NULL;
+  }
 
-  /* Sort each gauge. */
-  sorted_gauges = (Gauge **)calloc(gnet->h.ngauge, sizeof(Gauge *));
-  for (i=0; i<gnet->h.ngauge; i++) {
-	/* Test. */
+  for (i=0; i<n; i++) {
 	g = gnet->gauge[i];
-	g = Gsort_gauge_by_time(gnet->gauge[i]);  /* Allocates new Gauge. */
-	sorted_gauges[i] = g;
+	if (g == NULL || g->h.nobs <= 0) continue;
+	Gcheck_gauge_time_keys(g);
+	if (!gauge_is_sorted(g)) {
+	  m->order[i] = (int *)malloc(g->h.nobs*sizeof(int));
+	  if (m->order[i] == NULL || Gsort_gauge_order(g, m->order[i]) != OK) {
+		perror("Gnew_network_merge -- order");
+		Gfree_network_merge(m);
+		return NULL;
+	  }
+	}
+	m->heap[m->nheap++] = i;
+  }
+  for (k=m->nheap/2-1; k>=0; k--)
+	merge_sift_down(m, k);
+  return m;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                   Gnext_network_merge                     */
+/*                                                           */
+/*************************************************************/
+int Gnext_network_merge(Gnetwork_merge *m)
+{
+  /* Advances to the next time at which any gauge reported.  Sets
+	 m->time and m->rec[i] for every gauge i: its record at that time,
+	 or NULL.  A gauge with several records at one time contributes
+	 them to consecutive rows.
+
+	 Returns: the number of gauges with a record in the row, or
+	          0 when all records have been visited.
+  */
+  Gtime_key key;
+  int i, k;
+
+  if (m == NULL) return 0;
+  for (i=0; i<m->nmember; i++)
+	m->rec[m->member[i]] = NULL;
+  m->nmember = 0;
+  if (m->nheap == 0) return 0;
+
+  key = merge_key(m, m->heap[0]);
+  m->time = merge_head(m, m->heap[0])->time;
+  /* Take the gauges at 'key' off the heap first, so that one with
+   * several records at this time gives only one of them to the row.
+   */
+  while (m->nheap > 0 && merge_key(m, (i = m->heap[0])) == key) {
+	m->rec[i] = merge_head(m, i);
+	m->member[m->nmember++] = i;
+	m->heap[0] = m->heap[--m->nheap];
+	if (m->nheap > 0) merge_sift_down(m, 0);
+  }
+  for (k=0; k<m->nmember; k++) {
+	i = m->member[k];
+	if (++m->cursor[i] < m->gnet->gauge[i]->h.nobs)
+	  merge_sift_up(m, i);
+  }
+  return m->nmember;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                   Gfree_network_merge                     */
+/*                                                           */
+/*************************************************************/
+void Gfree_network_merge(Gnetwork_merge *m)
+{
+  int i;
+
+  if (m == NULL) return;
+  if (m->order) {
+	for (i=0; i<m->gnet->h.ngauge; i++)
+	  if (m->order[i]) free(m->order[i]);
+	free(m->order);
   }
+  if (m->cursor) free(m->cursor);
+  if (m->heap) free(m->heap);
+  if (m->member) free(m->member);
+  if (m->rec) free(m->rec);
+  free(m);
+}
 
-  /* Now merge the data by collecting all gauge measurements for
-   * each time.
+/*************************************************************/
+/*                                                           */
+/*                 Gsort_network_by_time                     */
+/*                                                           */
+/*************************************************************/
+Gauge_measurement_at_time *Gsort_network_by_time(Gauge_network *gnet)
+{
+  /*
+   * Collects the measurements of all gauges of 'gnet' by time.  Row t
+   * holds the time and val[0..ngauge-1], one per gauge in network
+   * order.  val[i].h is gauge i's header; h.nobs is 1 and 'ob' is the
+   * measurement (the first bin) when gauge i reported at that time,
+   * h.nobs is 0 when it did not.  The row after the last one has
+   * val == NULL.
    *
-   * a. Keep indexes, one for each gauge, and only bump
-   *    the index when the time is 'oldest' and the data is
-   *    inserted into the target.
+   * Use Gnew_network_merge to walk the network without building
+   * the rows.
    *
+   * Returns: rows, if success.  Free with Gfree_network_by_time.
+   *          NULL, otherwise.
    */
-  index = (int *)calloc(gnet->h.ngauge, sizeof(int));
-  done = 0;
-  while(! done) {
-	/* Done when all indexes exceed the # of all gauge measurements. */
-	for (i=0; i<gnet->h.ngauge; i++) {
-	  if (index[i] < sorted_gauges[i]->h.nobs) {
-		done = 0;
-		break;
-	  }
-	  done = !0;
-	}
+  Gauge_measurement_at_time *gmat, *new_gmat;
+  Gnetwork_merge *m;
+  Gauge_record *r;
+  int i, nrow, maxrow, ngauge;
 
-  } /* End while */  
-  free(index);
+  if (gnet == NULL) return NULL;
+  m = Gnew_network_merge(gnet);
+  if (m == NULL) return NULL;
+  ngauge = gnet->h.ngauge;
+
+  /* Every record of the longest gauge needs its own row. */
+  for (maxrow=1, i=0; i<ngauge; i++)
+	if (gnet->gauge[i] && gnet->gauge[i]->h.nobs >= maxrow)
+	  maxrow = gnet->gauge[i]->h.nobs + 1;
+  gmat = (Gauge_measurement_at_time *)calloc(maxrow, sizeof(*gmat));
+  if (gmat == NULL) goto fail;
+
+  for (nrow=0; Gnext_network_merge(m) > 0; nrow++) {
+	if (nrow+1 >= maxrow) {
+	  new_gmat = (Gauge_measurement_at_time *)
+		realloc(gmat, 2*maxrow*sizeof(*gmat));
+	  if (new_gmat == NULL) goto fail;
+	  gmat = new_gmat;
+	  memset(gmat+maxrow, 0, maxrow*sizeof(*gmat));
+	  maxrow *= 2;
+	}
+	gmat[nrow].time = m->time;
+	gmat[nrow].val = (Gauge_measurement *)
+	  calloc(ngauge > 0 ? ngauge : 1, sizeof(Gauge_measurement));
+	if (gmat[nrow].val == NULL) goto fail;
+	for (i=0; i<ngauge; i++) {
+	  if (gnet->gauge[i] == NULL) continue;
+	  gmat[nrow].val[i].h = gnet->gauge[i]->h;
+	  r = m->rec[i];
+	  gmat[nrow].val[i].h.nobs = (r != NULL);
+	  gmat[nrow].val[i].ob = r ? r->value[0] : 0.0;
+	}
+  }
+  gmat[nrow].val = NULL;
+  Gfree_network_merge(m);
   return gmat;
+
+ fail:
+  perror("Gsort_network_by_time");
+  Gfree_network_merge(m);
+  Gfree_network_by_time(gmat);
+  return NULL;
+}
+
+void Gfree_network_by_time(Gauge_measurement_at_time *gmat)
+{
+  int t;
+
+  if (gmat == NULL) return;
+  for (t=0; gmat[t].val != NULL; t++)
+	free(gmat[t].val);
+  free(gmat);
 }
 
 
@@ -35,6 +35,9 @@
 #ifndef __GSL_H__
 #define __GSL_H__ 1
 
+#include <stddef.h>
+#include <string.h>
+
 #define GSL_VERSION_STR "gsl-v1.4"
 #define MAX_GAUGE_NETWORKS 16   /* Max networks at one radar site. */
 #define MAX_NETWORK_GAUGES 300  /* Max gauges per gauge_network. */
@@ -59,11 +62,53 @@ typedef struct {
 	int ngauges;
 } Gauge_list;
 
+/* Hash index; see gsl_index.c. */
+typedef struct {
+  int           nslot;   /* Table size, a power of 2. */
+  int           nkey;    /* Number of entries. */
+  unsigned int *hash;    /* hash[0..nslot-1] */
+  int          *value;   /* value[0..nslot-1], -1 for an empty slot. */
+} Gindex;
+
+/* One line of the radar site database file 'radar.dat'. */
+typedef struct {
+  char  *gv_site;
+  char  *network;        /* Gauge network name. */
+  char  *radar;          /* Radar id: MELB, KWAJ, ... */
+  float  lat;            /* Radar latitude. */
+  float  lon;            /* Radar longitude. */
+  int    next_in_radar;  /* Next entry for the same radar, or -1. */
+} Gradar_entry;
+
+typedef struct {
+  char         *path;    /* File this catalog was read from. */
+  int           nentry;
+  Gradar_entry *entry;   /* entry[0..nentry-1], in file order. */
+  Gindex       *by_network;
+  Gindex       *by_radar;
+} Gradar_catalog;
+
+/* Region allocator; see gsl_arena.c. */
+typedef struct Garena_block Garena_block;
+typedef struct {
+  Garena_block *block;      /* Blocks, the one being filled first. */
+  size_t        block_size; /* Size of a regular block. */
+  size_t        nbytes;     /* Total bytes obtained from malloc. */
+} Garena;
+
 /* Need to include:
    1. Example strings for 'names', 'types', etc.
    2. Units for values.
    */
 
+/* Packed time: seconds since 1970-01-01 00:00:00.  See Gtime_to_key.
+ * Whole seconds: the fraction of Gauge_time.sec is dropped, so two
+ * records less than a second apart have equal keys.  Sorting and
+ * merging go by the key and keep such records in their original order;
+ * before v1.5 they were ordered by the fraction too.
+ */
+typedef long long Gtime_key;
+
 typedef struct {
   int   	year;		/* Year (4-digits: 19xx, or 20xx)*/
   int   	jday; 		/* Julian day from begining of the year (int 0-365) */
@@ -72,6 +117,10 @@ typedef struct {
   int   	hour;		/* Hour of the day (int 0-23) */
   int   	minute;     /* Minute of the day (int 0-59) */
   float 	sec; 		/* Second (float) */
+  Gtime_key key;        /* The fields above as one sortable number (whole
+						 * seconds).  Filled in by the readers; call
+						 * Gset_gauge_time_keys after editing the fields.
+						 */
 } Gauge_time;
 
 typedef struct {
@@ -83,6 +132,9 @@ typedef struct {
 										*/
 } Gauge_record;
 
+/* The strings of a Gauge_header, other than 'name', and of the network
+ * and complex headers are interned (see Gintern): shared, never freed.
+ */
 typedef struct {
   char    *network; /* Network name: KSC, STJ ... (Also in Network header */
   char    *gv_site; /* Can be HSTN, MELB, DARW, KWAJ, THOM, GUAM,
@@ -109,6 +161,8 @@ typedef struct {
 typedef struct {
   Gauge_header 	h;
   Gauge_record 	*record; /* 0..< h.nobs */
+  Garena        *arena;   /* Owner of this gauge's memory, or NULL if it
+						   * was malloc'ed (Gnew_gauge). */
 } Gauge;
 
 typedef struct {
@@ -121,6 +175,14 @@ typedef struct {
 typedef struct {
   Gauge_network_header h;
   Gauge **gauge; 			/* gauge[0..ngauge-1]. */
+  /* Lookup tables for Gfind_gauge_by_number/name.  They pick up gauges
+	 appended to 'gauge' automatically, on the next lookup; lookups from
+	 several threads are safe only while the tables are current (see
+	 Gindex_gauge_complex). */
+  Gindex *by_number;
+  Gindex *by_name;
+  int     nindexed;   /* gauge[0..nindexed-1] are in the tables. */
+  Garena *arena;      /* As for Gauge. */
 } Gauge_network;
 
 typedef struct {
@@ -132,6 +194,13 @@ typedef struct {
 typedef struct {
 	Gauge_complex_header h;
   Gauge_network **net; 	 /* net[0..nnet-1]. */
+  /* Lookup table for find_network_in_gauge_complex. */
+  Gindex *by_name;
+  int     nindexed;      /* net[0..nindexed-1] are in the table. */
+  Garena *arena;         /* Set by Gnew_gauge_complex_arena: everything
+						  * in the complex lives in this arena. */
+  char   *map;           /* Set by Gmap_binary: the mapped file ... */
+  size_t  map_len;       /* ... and its length. */
 } Gauge_complex;
 
 typedef struct {
@@ -147,20 +216,154 @@ typedef struct {
   Gauge_measurement *val; /* 0..<Gauge_network->h.ngauge */
 } Gauge_measurement_at_time;
 
+/* Walks the records of all gauges of a network in time order; see
+ * Gnew_network_merge.
+ */
+typedef struct {
+  Gauge_network *gnet;
+  int          **order;   /* order[i]: Gsort_gauge_order of gauge i, or
+						   * NULL when that gauge is already sorted. */
+  int           *cursor;  /* cursor[i]: next position in gauge i. */
+  int           *heap;    /* Gauges with records left, earliest first. */
+  int            nheap;
+  int           *member;  /* Gauges in the current row ... */
+  int            nmember; /* ... and how many. */
+  Gauge_time     time;    /* Time of the current row. */
+  Gauge_record **rec;     /* rec[0..ngauge-1]: gauge i's record at 'time',
+						   * or NULL if it has none. */
+} Gnetwork_merge;
+
+
+/* The records of one gauge in a time window; see gsl_query.c. */
+typedef struct {
+  Gauge        *g;
+  int           first;   /* g->record[first..first+n-1] ... */
+  int           n;
+  Gauge_record *record;  /* ... starting here; NULL when n == 0. */
+} Gtime_slice;
+
+/* Columnar copy of gauges; see gsl_column.c.  Row r of the matrix is
+ * value[r*nbin .. r*nbin+nbin-1], recorded at key[r].
+ */
+typedef struct {
+  Gauge_network_header nh; /* Header of the network, if made from one. */
+  int           ngauge;
+  Gauge_header *h;         /* h[0..ngauge-1], the gauge headers. */
+  int          *start;     /* Gauge i is rows start[i]..start[i+1]-1. */
+  int           nrow;      /* Rows of all gauges; start[ngauge]. */
+  int           nbin;      /* Values per row. */
+  Gtime_key    *key;       /* key[0..nrow-1] */
+  float        *value;     /* value[0..nrow*nbin-1] */
+} Gauge_columns;
+
+#define Gcolumn_nrow(c, i)   ((c)->start[(i)+1] - (c)->start[i])
+#define Gcolumn_key(c, i)    ((c)->key + (c)->start[i])
+#define Gcolumn_value(c, i)  ((c)->value + (c)->start[i]*(c)->nbin)
+
+/* Quantities derived from one disdrometer record; see gsl_dsd.c. */
+#define GSL_DSD_NBIN   20     /* Size classes of a disdrometer record. */
+#define GSL_DSD_NO_DBZ -99.0  /* dbz of a record without drops. */
+typedef struct {
+  float rain_rate;  /* mm/hr */
+  float z;          /* Reflectivity factor, mm^6 m^-3 */
+  float dbz;        /* 10 log10(z) */
+  float lwc;        /* Liquid water content, g m^-3 */
+  float dm;         /* Mass weighted mean diameter, mm */
+  float d0;         /* Median volume diameter, mm */
+} Gdsd_moments;
+
+/* Follows a GMIN file that is still being written; see Gopen_follow. */
+typedef struct {
+  char     *file;
+  Gauge    *g;           /* Observations read so far; NULL before the
+						  * header line has been read. */
+  long long offset;      /* Bytes used: up to the last complete line. */
+  long      inode;       /* Of the file at 'offset', to notice a new one. */
+  int       have_header; /* Nonzero once g->h is from the current file. */
+  int       nalloc;      /* Records allocated in g; >= g->h.nobs. */
+  char     *buf;         /* Read buffer ... */
+  long long nbuf;        /* ... and its size. */
+} Gfollow;
+
+/* A 2A-56/2A-57 HDF file read on demand; see Gopen_hdf_complex. */
+typedef struct {
+  Gauge_complex *gc;   /* Gauges are NULL until read. */
+  char  *file;
+  int    productType;
+  void  *ioh;          /* Toolkit IO_HANDLE. */
+  void  *stage;        /* L2A structure gauges are read into. */
+  int    open;         /* Nonzero while 'ioh' is open. */
+  int    next;         /* Gauge 'ioh' reads next, in file order; -1: lost. */
+  int   *net_start;    /* Network j's gauges start at net_start[j]. */
+  Gtime_key day;       /* 00:00 of the granule's date (from the file name). */
+} Ghdf_complex;
+
+/* Gauge sites bucketed on a lat/lon grid; see gsl_site.c. */
+typedef struct {
+  int     nsite;
+  float  *lat, *lon;        /* Of site 0..nsite-1, degrees. */
+  Gauge **gauge;            /* Site i's gauge, or NULL; see
+							 * Gsite_index_of_complex. */
+  double  lat0, lon0;       /* South-west corner of cell 0. */
+  double  dlat, dlon;       /* Cell size, degrees. */
+  double  cell_km;          /* Least cell width, km. */
+  double  abs_lat;          /* Largest |lat| of a site. */
+  int     nx, ny;           /* Cells across and up. */
+  int    *start;            /* Cell c holds site[start[c]..start[c+1]-1]. */
+  int    *site;
+  float   radar_lat, radar_lon;
+  int     has_radar;
+} Gsite_index;
+
+/* Gauges placed on a radar's polar grid; see gsl_lut.c. */
+typedef struct {
+  float   az_step;       /* Degrees between rays; 360/nray. */
+  float   gate_km;       /* Gate depth. */
+  float   max_range;     /* km; gauges at or beyond it are in no bin. */
+  int     nray, ngate;   /* Bin b is ray b/ngate, gate b%ngate. */
+  int     ngauge;
+  int    *gauge_bin;     /* gauge_bin[i]: gauge i's bin, or -1. */
+  int     nbin;          /* Bins holding gauges: bin[0..nbin-1] ... */
+  int    *bin;
+  int    *start;         /* ... holding gauge[start[k]..start[k+1]-1]. */
+  int    *gauge;
+  Gindex *by_bin;        /* Bin number -> k. */
+  unsigned int key;      /* Cache key; see Gpolar_lut_for_sitelist. */
+} Gpolar_lut;
 
 /* Read gauge/disdrometer raw data files */
 Gauge *Gread_disdro_gauge(char *infile);
+Gauge *Gread_disdro_mmap(char *infile, Garena *a);
 Gauge *Gread_gmin(char *infile);
+Gauge *Gread_gmin_mmap(char *infile, Garena *a);
+Gfollow *Gopen_follow(char *infile);
+int      Gfollow_gmin(Gfollow *f);
+void     Gclose_follow(Gfollow *f);
+
+/* Read/write GSL binary files. */
+int            Gwrite_binary(Gauge_complex *gc, char *file);
+int            Gwrite_binary_gauge(Gauge *g, char *file);
+Gauge_complex *Gmap_binary(char *file);
+int            Gbinary_is_current(char *binfile, int nfile, char **file);
 
 /* Read/write HDF files. */
 int Gauge_complex_to_hdf(Gauge_complex *gcomplex, char *hdffile);
+int Gauge_complex_to_hdf_by_day(Gauge_complex *gcomplex, char *dir,
+								int nthread);
 Gauge_complex *Ghdf_to_gauge_complex(char *hdffile);
+Ghdf_complex  *Gopen_hdf_complex(char *hdffile);
+void           Gclose_hdf_complex(Ghdf_complex *hc);
+Gauge         *Ghdf_gauge(Ghdf_complex *hc, int net, int i);
+Gauge_network *Ghdf_network(Ghdf_complex *hc, int net);
+Gauge_network *Ghdf_network_by_name(Ghdf_complex *hc, char *netName);
 
 /* Memory allocation */
 Gauge            *Gnew_gauge(int nobs, int nbin);
 Gauge_network    *Gnew_gauge_network(int ngauge);
 Gauge_complex    *Gnew_gauge_complex(int nnet);
+Gauge_complex    *Gnew_gauge_complex_arena(int nnet);
 Gauge            *Gcopy_gauge(Gauge *g);
+Gauge            *Gresize_gauge(Gauge *g, int nobs);
 
 /* Memory deallocation. */
 void Gfree_gauge(Gauge *gauge);
@@ -172,13 +375,48 @@ Gauge            *Gclear_gauge(Gauge *gauge);
 Gauge_network    *Gclear_gauge_network(Gauge_network *network);
 Gauge_complex *Gclear_gauge_complex(Gauge_complex *site);
 
+/* Time keys */
+Gtime_key Gmake_time_key(int year, int jday, int hour, int minute, float sec);
+int       Gjulian(int mo, int day, int year);
+Gtime_key Gtime_to_key(Gauge_time *t);
+void      Gkey_to_time(Gtime_key key, Gauge_time *t);
+void      Gset_gauge_time_keys(Gauge *g);
+void      Gcheck_gauge_time_keys(Gauge *g);
+
+/* Sorting */
+Gauge *Gsort_gauge_by_time(Gauge *g);
+int    Gsort_gauge_in_place(Gauge *g);
+int    Gsort_gauge_order(Gauge *g, int *order);
+Gauge_measurement_at_time *Gsort_network_by_time(Gauge_network *gnet);
+void   Gfree_network_by_time(Gauge_measurement_at_time *gmat);
+Gnetwork_merge *Gnew_network_merge(Gauge_network *gnet);
+int    Gnext_network_merge(Gnetwork_merge *m);
+void   Gfree_network_merge(Gnetwork_merge *m);
+
+/* Time window queries */
+int Gquery_gauge_time_range(Gauge *g, Gtime_key t0, Gtime_key t1,
+							int *first);
+int Gquery_network_time_range(Gauge_network *gnet, Gtime_key t0,
+							  Gtime_key t1, Gtime_slice *slice);
+
 /* Miscellaneous */
 Gauge_complex *Gconstruct_gauge_complex(int nfile, char **file,
 										int instrument);
+Gauge_complex *Gconstruct_gauge_complex_arena(int nfile, char **file,
+											  int instrument, int nthread);
+Gauge_complex *Gconstruct_gauge_complex_parallel(int nfile, char **file,
+												 int instrument, int nthread);
 void print_network(Gauge_network *gnet);
 char *find_gauge_radarSite(char *netName);
 Gauge_network *find_network_in_gauge_complex(Gauge_complex *gc, 
 											 char *netName);
+Gauge *Gfind_gauge_by_number(Gauge_network *gnet, int number);
+Gauge *Gfind_gauge_by_name(Gauge_network *gnet, char *name);
+Gauge *Gfind_gauge_in_complex(Gauge_complex *gc, char *netName, int number);
+Gauge *Gfind_gauge_in_complex_by_name(Gauge_complex *gc, char *netName,
+									  char *name);
+int    Gindex_gauge_complex(Gauge_complex *gc);
+int    Gindex_gauge_network(Gauge_network *gnet);
 
 /* Gauge info */
 int get_gauge_networks_for_radar_site(char *top_dir, char *radar_id, 
@@ -187,5 +425,116 @@ int get_gauge_networks_for_radar_site(char *top_dir, char *radar_id,
 Gauge_list *get_gauge_sites_info(char *top_dir, char *gnet,
 																 float radarLat, float radarLon);
 void free_gauge_list(Gauge_list *glist);
+void gauge_range_azimuth(float radar_lat, float radar_lon,
+						 float point_lat, float point_lon,
+						 float *range, float *azim);
+void gauge_range_azimuth_batch(float radar_lat, float radar_lon, int n,
+							   const float *point_lat, const float *point_lon,
+							   float *range, float *azim);
+
+/* Site index */
+Gsite_index *Gnew_site_index(int n, float *lat, float *lon, float cell_km);
+Gsite_index *Gsite_index_of_list(Gauge_list *glist, float cell_km);
+Gsite_index *Gsite_index_of_complex(Gauge_complex *gc, float cell_km);
+void Gfree_site_index(Gsite_index *ix);
+int  Gsite_index_cell(Gsite_index *ix, float lat, float lon);
+void Gset_site_index_radar(Gsite_index *ix, float radar_lat, float radar_lon);
+int  Gsites_within(Gsite_index *ix, float lat, float lon, float radius,
+				   int max, int *site, float *dist);
+int  Gsites_nearest(Gsite_index *ix, float lat, float lon, int k,
+					int *site, float *dist);
+int  Gsites_within_polar(Gsite_index *ix, float range, float azimuth,
+						 float radius, int max, int *site, float *dist);
+int  Gsites_nearest_polar(Gsite_index *ix, float range, float azimuth, int k,
+						  int *site, float *dist);
+
+/* Polar lookup table */
+Gpolar_lut *Gnew_polar_lut(int ngauge, float *range, float *azimuth,
+						   float az_step, float gate_km, float max_range);
+Gpolar_lut *Gpolar_lut_of_list(Gauge_list *glist, float az_step,
+							   float gate_km, float max_range);
+Gpolar_lut *Gpolar_lut_of_network(Gauge_network *gnet, float az_step,
+								  float gate_km, float max_range);
+Gpolar_lut *Gpolar_lut_for_sitelist(char *top_dir, char *gnet,
+									float radarLat, float radarLon,
+									float az_step, float gate_km,
+									float max_range, char *cache_dir);
+void Gfree_polar_lut(Gpolar_lut *lut);
+int  Gpolar_lut_gauges(Gpolar_lut *lut, int ray, int gate, int **gauge);
+int  Gpolar_lut_bin(Gpolar_lut *lut, int i, int *ray, int *gate);
+
+/* Radar site catalog */
+Gradar_catalog *Gload_radar_catalog(char *path);
+void            Gfree_radar_catalog(Gradar_catalog *cat);
+void            Gset_radar_catalog_path(char *path);
+char           *Gradar_catalog_path(void);
+Gradar_catalog *Gradar_catalog_for(char *path);
+Gradar_entry   *Gfind_radar_by_network(Gradar_catalog *cat, char *netName);
+Gradar_entry   *Gfind_radar_entries(Gradar_catalog *cat, char *radar_id);
+
+/* Hash index */
+unsigned int Ghash_string(char *s);
+unsigned int Ghash_int(int n);
+Gindex *Gnew_index(int nkey);
+void    Gfree_index(Gindex *ix);
+void    Gclear_index(Gindex *ix);
+int     Gindex_add(Gindex *ix, unsigned int hash, int value);
+int     Gindex_find(Gindex *ix, unsigned int hash,
+					int (*same)(int value, void *arg), void *arg);
+
+/* Columnar view */
+Gauge_columns *Ggauge_to_columns(Gauge *g);
+Gauge_columns *Gnetwork_to_columns(Gauge_network *gnet);
+Gauge         *Gcolumns_to_gauge(Gauge_columns *c, int i);
+Gauge_network *Gcolumns_to_network(Gauge_columns *c);
+void           Gfree_columns(Gauge_columns *c);
+
+/* Region allocator */
+Garena *Gnew_arena(size_t block_size);
+void    Gfree_arena(Garena *a);
+void   *Garena_alloc(Garena *a, size_t n);
+char   *Garena_strdup(Garena *a, char *s);
+Gauge  *Garena_new_gauge(Garena *a, int nobs, int nbin);
+Gauge  *Garena_copy_gauge(Garena *a, Gauge *g);
+
+/* Interned strings */
+char *Gintern(char *s);
+/* Equal strings; a pointer compare when both are interned. */
+#define Gsame_string(a, b) \
+  ((a) == (b) || ((a) != NULL && (b) != NULL && strcmp((a), (b)) == 0))
+
+/* Rainfall accumulation */
+#define GSL_HOUR 3600   /* Seconds; the 'step' of hourly totals. */
+#define GSL_DAY  86400
+int Gaccumulate_gauge(Gauge *g, Gtime_key start, int step, int nstep,
+					  float *total, float *max);
+int Gaccumulate_network(Gauge_network *gnet, Gtime_key start, int step,
+						int nstep, float *total, float *max);
+int Gaccumulate_columns(Gauge_columns *c, Gtime_key start, int step,
+						int nstep, float *total, float *max);
+
+/* Resampling */
+#define GSL_RESAMPLE_MEAN  0   /* Mean rate, mm/hr. */
+#define GSL_RESAMPLE_ACCUM 1   /* Rain total, mm. */
+#define GSL_RESAMPLE_MAX   2   /* Largest rate, mm/hr. */
+#define GSL_GAPS_ZERO      0   /* Gaps are no rain. */
+#define GSL_GAPS_MISSING   1   /* Cells short of data are 'missing'. */
+int Gresample_network(Gauge_network *gnet, Gtime_key start, int step,
+					  int nstep, int how, int gaps, float min_cover,
+					  float missing, int nthread, float *out);
+int Gresample_complex(Gauge_complex *gc, Gtime_key start, int step,
+					  int nstep, int how, int gaps, float min_cover,
+					  float missing, int nthread, float *out);
+
+/* Drop size distribution */
+int Gdsd_bin_size(int bin, float *diameter, float *width, float *velocity);
+int Gdsd_moments_gauge(Gauge *g, Gdsd_moments *m);
+int Gdsd_moments_network(Gauge_network *gnet, Gdsd_moments *m);
+int Gdsd_moments_columns(Gauge_columns *c, Gdsd_moments *m);
+
+/* Threads */
+int Gnumber_of_threads(int nthread);
+int Gparallel_for(int njob, int nthread, void (*job)(int i, void *arg),
+				  void *arg);
 
 #endif
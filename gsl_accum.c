@@ -0,0 +1,299 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************
+
+	Rainfall accumulation.
+
+	A raingauge record holds a rain rate in mm/hr (value[0]) that
+	applies for h.resolution minutes, so it contributes
+	rate * resolution / 60 mm of rain.  The functions below add
+	these up over 'nstep' consecutive intervals of 'step' seconds,
+	the first one starting at time key 'start':
+
+	    interval k = [start + k*step, start + (k+1)*step)
+
+	and find the largest rate in each interval.  Negative rates
+	(missing data flags) and NaNs count as no rain.
+
+	When the records are in time order and laid out as Gnew_gauge
+	does it, each interval is a contiguous run of floats and is summed
+	with SSE; otherwise each record is binned on its own.
+
+*******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "gsl.h"
+
+/*************************************************************/
+/*                                                           */
+/*                     Summing kernels                       */
+/*                                                           */
+/*************************************************************/
+static float rate_of(float x)
+{
+  return (x > 0) ? x : 0;  /* Also 0 for a NaN. */
+}
+
+static float sum_rates(const float *x, int n, int stride)
+{
+  float sum = 0;
+  int j = 0;
+#ifdef __SSE2__
+  __m128 zero, s0, s1;
+  float part[4];
+
+  if (stride == 1 && n >= 8) {
+	zero = _mm_setzero_ps();
+	s0 = s1 = zero;
+	/* max(x, 0) is 0 for negative values and NaNs, as in rate_of. */
+	for (; j+8 <= n; j += 8) {
+	  s0 = _mm_add_ps(s0, _mm_max_ps(_mm_loadu_ps(x+j),   zero));
+	  s1 = _mm_add_ps(s1, _mm_max_ps(_mm_loadu_ps(x+j+4), zero));
+	}
+	_mm_storeu_ps(part, _mm_add_ps(s0, s1));
+	sum = (part[0] + part[1]) + (part[2] + part[3]);
+  }
+#endif
+  for (; j<n; j++)
+	sum += rate_of(x[j*stride]);
+  return sum;
+}
+
+static float max_rates(const float *x, int n, int stride)
+{
+  float max = 0;
+  int j = 0;
+#ifdef __SSE2__
+  __m128 m0, m1;
+  float part[4];
+  int k;
+
+  if (stride == 1 && n >= 8) {
+	m0 = m1 = _mm_setzero_ps();
+	for (; j+8 <= n; j += 8) {
+	  m0 = _mm_max_ps(_mm_loadu_ps(x+j),   m0);
+	  m1 = _mm_max_ps(_mm_loadu_ps(x+j+4), m1);
+	}
+	_mm_storeu_ps(part, _mm_max_ps(m0, m1));
+	for (k=0; k<4; k++)
+	  if (part[k] > max) max = part[k];
+  }
+#endif
+  for (; j<n; j++)
+	if (x[j*stride] > max) max = x[j*stride];
+  return max;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                    Gaccumulate_rates                      */
+/*                                                           */
+/*************************************************************/
+/* Time keys are passed as a base address and a stride in bytes, so
+ * they can be read straight out of a Gauge_record array.
+ */
+#define KEY(key, j, kstride) (*(Gtime_key *)((key) + (j)*(kstride)))
+
+static int is_sorted(char *key, int n, int kstride)
+{
+  int j;
+
+  for (j=1; j<n; j++)
+	if (KEY(key, j, kstride) < KEY(key, j-1, kstride)) return 0;
+  return 1;
+}
+
+static int first_at_or_after(char *key, int n, int kstride, Gtime_key t)
+{
+  /* Binary search in sorted keys: the first j with key >= t. */
+  int lo = 0, hi = n, mid;
+
+  while (lo < hi) {
+	mid = (lo + hi)/2;
+	if (KEY(key, mid, kstride) < t) lo = mid+1;
+	else hi = mid;
+  }
+  return lo;
+}
+
+static void accumulate(char *key, int kstride, float *rate, int rstride,
+					   int n, float depth, Gtime_key start, int step,
+					   int nstep, float *total, float *max)
+{
+  /* KEY(key, j, kstride) and rate[j*rstride], j=0..n-1: time keys and rain
+   * rates of one gauge.  'depth' converts a rate to mm.
+   */
+  Gtime_key end;
+  int j, j2, k;
+
+  if (total) memset(total, 0, nstep*sizeof(float));
+  if (max)   memset(max,   0, nstep*sizeof(float));
+  if (n <= 0 || nstep <= 0 || step <= 0) return;
+
+  if (is_sorted(key, n, kstride)) {
+	/* Intervals are runs of records: sum each run at once. */
+	j = first_at_or_after(key, n, kstride, start);
+	for (k=0; k<nstep && j<n; k++) {
+	  end = start + (Gtime_key)(k+1)*step;
+	  for (j2=j; j2<n && KEY(key, j2, kstride) < end; j2++)
+		continue;
+	  if (total) total[k] = depth*sum_rates(rate + j*rstride, j2-j, rstride);
+	  if (max)   max[k]   = max_rates(rate + j*rstride, j2-j, rstride);
+	  j = j2;
+	}
+	return;
+  }
+
+  for (j=0; j<n; j++) {
+	if (KEY(key, j, kstride) < start) continue;
+	k = (int)((KEY(key, j, kstride) - start)/step);
+	if (k >= nstep) continue;
+	if (total) total[k] += depth*rate_of(rate[j*rstride]);
+	if (max && rate[j*rstride] > max[k]) max[k] = rate[j*rstride];
+  }
+}
+
+static float depth_factor(Gauge_header *h)
+{
+  /* mm per (mm/hr) of one record. */
+  return ((h->resolution > 0) ? h->resolution : 1.0)/60.0;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                   Gaccumulate_gauge                       */
+/*                                                           */
+/*************************************************************/
+int Gaccumulate_gauge(Gauge *g, Gtime_key start, int step, int nstep,
+					  float *total, float *max)
+{
+  /* Rain totals (mm) into total[0..nstep-1] and peak rain rates
+	 (mm/hr) into max[0..nstep-1], for intervals of 'step' seconds
+	 from time key 'start' (see Gmake_time_key).  Use step = GSL_HOUR
+	 for hourly and GSL_DAY for daily values.  Either array may be
+	 NULL.
+
+	 Returns: OK, if success.
+	          ABORT, if out of memory.
+  */
+  Gtime_key *key;
+  int j, n, nbin, contiguous;
+
+  if (g == NULL) return ABORT;
+  Gcheck_gauge_time_keys(g);
+  n = g->h.nobs;
+  nbin = (g->h.nbin > 0) ? g->h.nbin : 1;
+  if (n <= 0) {
+	accumulate(NULL, 0, NULL, 1, 0, 0, start, step, nstep, total, max);
+	return OK;
+  }
+
+  /* The keys sit in the records, one Gauge_record apart.  The rates
+   * are nbin floats apart when the values are in one block.
+   */
+  for (contiguous=1, j=0; j<n && contiguous; j++)
+	contiguous = (g->record[j].value == g->record->value + j*nbin);
+  if (contiguous) {
+	accumulate((char *)&g->record->time.key, sizeof(Gauge_record),
+			   g->record->value, nbin, n, depth_factor(&g->h),
+			   start, step, nstep, total, max);
+	return OK;
+  }
+
+  /* Gather the rates of a gauge built by hand. */
+  key = (Gtime_key *)malloc(n*(sizeof(Gtime_key) + sizeof(float)));
+  if (key == NULL) {
+	perror("Gaccumulate_gauge");
+	return ABORT;
+  }
+  for (j=0; j<n; j++) {
+	key[j] = g->record[j].time.key;
+	((float *)(key + n))[j] = g->record[j].value[0];
+  }
+  accumulate((char *)key, sizeof(Gtime_key), (float *)(key + n), 1, n, depth_factor(&g->h),
+			 start, step, nstep, total, max);
+  free(key);
+  return OK;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                   Gaccumulate_network                     */
+/*                                                           */
+/*************************************************************/
+int Gaccumulate_network(Gauge_network *gnet, Gtime_key start, int step,
+						int nstep, float *total, float *max)
+{
+  /* Gaccumulate_gauge for every gauge of 'gnet': gauge i's values go
+	 to total[i*nstep .. i*nstep+nstep-1], and likewise for 'max'.  A
+	 gauge not read yet (see Gopen_hdf_complex) gets zeros.
+
+	 Returns: OK, if success.
+	          ABORT, otherwise.
+  */
+  int i, k;
+
+  if (gnet == NULL) return ABORT;
+  for (i=0; i<gnet->h.ngauge; i++) {
+	if (gnet->gauge[i] == NULL) {
+	  for (k=0; k<nstep; k++) {
+		if (total) total[i*nstep + k] = 0;
+		if (max)   max[i*nstep + k]   = 0;
+	  }
+	  continue;
+	}
+	if (Gaccumulate_gauge(gnet->gauge[i], start, step, nstep,
+						  total ? total + i*nstep : NULL,
+						  max   ? max   + i*nstep : NULL) != OK)
+	  return ABORT;
+  }
+  return OK;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                   Gaccumulate_columns                     */
+/*                                                           */
+/*************************************************************/
+int Gaccumulate_columns(Gauge_columns *c, Gtime_key start, int step,
+						int nstep, float *total, float *max)
+{
+  /* As Gaccumulate_network, for the gauges of a Gauge_columns.  With
+	 nbin == 1 the rates of a gauge are one contiguous array.
+  */
+  int i;
+
+  if (c == NULL) return ABORT;
+  for (i=0; i<c->ngauge; i++)
+	accumulate((char *)Gcolumn_key(c, i), sizeof(Gtime_key),
+			   Gcolumn_value(c, i), c->nbin,
+			   Gcolumn_nrow(c, i), depth_factor(&c->h[i]), start, step, nstep,
+			   total ? total + i*nstep : NULL,
+			   max   ? max   + i*nstep : NULL);
+  return OK;
+}
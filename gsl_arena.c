@@ -0,0 +1,209 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************
+
+	Region allocator for gauge complexes.
+
+	A 'Garena' hands out memory from a chain of large blocks and can
+	only be freed as a whole.  A complex made by
+	Gnew_gauge_complex_arena keeps its networks, gauges, records,
+	values and gauge names in one arena, so building it costs a
+	few large mallocs and Gfree_gauge_complex gives everything back
+	by freeing the blocks.
+
+*******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gsl.h"
+
+#define ARENA_ALIGN      16
+#define ARENA_BLOCK_SIZE (1024*1024)
+
+/* Block header; the memory handed out follows it. */
+struct Garena_block {
+  struct Garena_block *next;
+  size_t size;     /* Bytes after the header. */
+  size_t used;
+  double align[1]; /* Keeps the data suitably aligned. */
+};
+#define BLOCK_HEADER (((sizeof(Garena_block) + ARENA_ALIGN-1)/ARENA_ALIGN)*ARENA_ALIGN)
+
+/*************************************************************/
+/*                                                           */
+/*                   Gnew_arena / Gfree_arena                */
+/*                                                           */
+/*************************************************************/
+Garena *Gnew_arena(size_t block_size)
+{
+  /* An empty arena that allocates 'block_size' bytes at a time
+	 (0: one megabyte).
+  */
+  Garena *a;
+
+  a = (Garena *)calloc(1, sizeof(Garena));
+  if (a == NULL) {
+	perror("Gnew_arena");
+	return NULL;
+  }
+  a->block_size = (block_size > 0) ? block_size : ARENA_BLOCK_SIZE;
+  return a;
+}
+
+void Gfree_arena(Garena *a)
+{
+  /* Frees the arena and everything allocated from it. */
+  Garena_block *b, *next;
+
+  if (a == NULL) return;
+  for (b = a->block; b != NULL; b = next) {
+	next = b->next;
+	free(b);
+  }
+  free(a);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                      Garena_alloc                         */
+/*                                                           */
+/*************************************************************/
+void *Garena_alloc(Garena *a, size_t n)
+{
+  /* 'n' zeroed bytes from arena 'a', aligned for any GSL type.
+	 There is no way to free them short of Gfree_arena.
+
+	 Returns: pointer, if success.
+	          NULL, if out of memory.
+  */
+  Garena_block *b;
+  size_t size;
+  char *p;
+
+  if (a == NULL) return NULL;
+  n = ((n + ARENA_ALIGN-1)/ARENA_ALIGN)*ARENA_ALIGN;
+  b = a->block;
+  if (b == NULL || b->used + n > b->size) {
+	/* Large requests get a block of their own, which goes behind the
+	 * current one so the space left in it is not wasted.
+	 */
+	size = (n > a->block_size/4) ? n : a->block_size;
+	b = (Garena_block *)malloc(BLOCK_HEADER + size);
+	if (b == NULL) {
+	  perror("Garena_alloc");
+	  return NULL;
+	}
+	b->size = size;
+	b->used = 0;
+	if (size == n && a->block != NULL) {
+	  b->next = a->block->next;
+	  a->block->next = b;
+	} else {
+	  b->next = a->block;
+	  a->block = b;
+	}
+	a->nbytes += BLOCK_HEADER + size;
+  }
+  p = (char *)b + BLOCK_HEADER + b->used;
+  b->used += n;
+  memset(p, 0, n);
+  return (void *)p;
+}
+
+char *Garena_strdup(Garena *a, char *s)
+{
+  char *p;
+
+  if (s == NULL) return NULL;
+  p = (char *)Garena_alloc(a, strlen(s)+1);
+  if (p != NULL) strcpy(p, s);
+  return p;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                    Garena_new_gauge                       */
+/*                                                           */
+/*************************************************************/
+Gauge *Garena_new_gauge(Garena *a, int nobs, int nbin)
+{
+  /* Gnew_gauge, but made from arena 'a'.  The gauge cannot grow
+	 (Gresize_gauge refuses it) and goes away with the arena.
+
+	 Returns: gauge, if success.
+	          NULL, if out of memory.
+  */
+  Gauge *g;
+  int j;
+
+  if (a == NULL || nobs < 0 || nbin < 0) return NULL;
+  g = (Gauge *)Garena_alloc(a, sizeof(Gauge));
+  if (g == NULL) return NULL;
+  g->arena = a;
+  g->h.nobs = nobs;
+  g->h.nbin = nbin;
+  g->record = (Gauge_record *)Garena_alloc(a, (nobs+1)*sizeof(Gauge_record));
+  if (g->record == NULL) return NULL;
+  g->record->value = (float *)Garena_alloc(a, (nobs*nbin+1)*sizeof(float));
+  if (g->record->value == NULL) return NULL;
+  for (j=1; j<nobs; j++)
+	g->record[j].value = g->record->value + j*nbin;
+  return g;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                    Garena_copy_gauge                      */
+/*                                                           */
+/*************************************************************/
+Gauge *Garena_copy_gauge(Garena *a, Gauge *g)
+{
+  /* A copy of 'g' -- header strings, records and values -- made
+	 entirely from arena 'a'.  Gfree_gauge ignores such a gauge; it
+	 goes away with the arena.
+
+	 Returns: the copy, if success.
+	          NULL, if out of memory.
+  */
+  Gauge *newg;
+  int j, nbin;
+
+  if (a == NULL || g == NULL) return NULL;
+  newg = Garena_new_gauge(a, g->h.nobs, g->h.nbin);
+  if (newg == NULL) return NULL;
+  newg->h = g->h;
+  newg->h.name       = Garena_strdup(a, g->h.name);
+  newg->h.network    = Gintern(g->h.network);
+  newg->h.gv_site    = Gintern(g->h.gv_site);
+  newg->h.product_id = Gintern(g->h.product_id);
+  newg->h.type       = Gintern(g->h.type);
+  newg->h.radar      = Gintern(g->h.radar);
+
+  nbin = g->h.nbin;
+  for (j=0; j<g->h.nobs; j++) {
+	newg->record[j].time  = g->record[j].time;
+	memcpy(newg->record[j].value, g->record[j].value, nbin*sizeof(float));
+  }
+  return newg;
+}
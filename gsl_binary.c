@@ -0,0 +1,540 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************
+
+	GSL binary files: a parsed Gauge_complex saved as is, so that it
+	can be loaded again without reading the ASCII gauge files.
+
+	Layout (native byte order; all offsets are from the start of the
+	file):
+
+	    Bin_header                       fixed size, magic + version
+	    string table                     nstring offsets, then the
+	                                     NUL terminated strings
+	    Bin_network[nnet]
+	    Bin_gauge[ngauge]                networks' gauges, in order
+	    per gauge, 16 byte aligned:
+	        Gtime_key key[nobs]
+	        float     value[nobs*nbin]
+
+	Gmap_binary maps the file and builds the complex around it: the
+	value blocks are used where they lie in the mapping, only the
+	structures and record times are made (in the complex's arena).
+
+*******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "gsl.h"
+
+#define BIN_MAGIC      "GSLBIN\r\n"
+#define BIN_VERSION    1
+#define BIN_BYTE_ORDER 0x01020304
+#define BIN_ALIGN      16
+#define NO_STRING      (-1)
+
+typedef struct {
+  char      magic[8];
+  int       version;
+  int       byte_order;    /* BIN_BYTE_ORDER as written. */
+  int       header_size;   /* sizeof(Bin_header), sizeof(Bin_network), */
+  int       network_size;  /* sizeof(Bin_gauge): guard against a file */
+  int       gauge_size;    /* from a different ABI. */
+  int       nstring;
+  int       nnet;
+  int       ngauge;
+  int       radar_site;    /* String index. */
+  int       pad;
+  long long string_offset;
+  long long network_offset;
+  long long gauge_offset;
+  long long file_size;
+} Bin_header;
+
+typedef struct {
+  int name, location, type;  /* String indices. */
+  int first_gauge;           /* Index into the Bin_gauge table. */
+  int ngauge;
+  int pad;
+} Bin_network;
+
+typedef struct {
+  int       network, gv_site, product_id, name, type, radar; /* Strings. */
+  int       number;
+  int       nobs;
+  int       nbin;
+  float     resolution, lat, lon, azimuth, range, elevation;
+  int       pad;
+  long long key_offset;
+  long long value_offset;
+} Bin_gauge;
+
+static long long align(long long n)
+{
+  return ((n + BIN_ALIGN-1)/BIN_ALIGN)*BIN_ALIGN;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                       String table                        */
+/*                                                           */
+/*************************************************************/
+typedef struct {
+  char  **s;       /* Distinct strings ... */
+  int     n, max;
+  Gindex *ix;      /* ... and their hash table. */
+  long long bytes; /* Characters, with the NULs. */
+} String_table;
+
+static int same_entry(int j, void *arg)
+{
+  void **a = (void **)arg;
+  return strcmp(((String_table *)a[0])->s[j], (char *)a[1]) == 0;
+}
+
+static int string_index(String_table *t, char *s)
+{
+  /* Index of 's' in the table, entering it if new; -1 for NULL, or
+   * -2 if out of memory.
+   */
+  void *arg[2];
+  char **new_s;
+  int j;
+
+  if (s == NULL) return NO_STRING;
+  arg[0] = t;
+  arg[1] = s;
+  j = Gindex_find(t->ix, Ghash_string(s), same_entry, arg);
+  if (j >= 0) return j;
+  if (t->n == t->max) {
+	new_s = (char **)realloc(t->s, (2*t->max+64)*sizeof(char *));
+	if (new_s == NULL) return -2;
+	t->s = new_s;
+	t->max = 2*t->max+64;
+  }
+  t->s[t->n] = s;
+  if (Gindex_add(t->ix, Ghash_string(s), t->n) != OK) return -2;
+  t->bytes += strlen(s) + 1;
+  return t->n++;
+}
+
+static int write_padding(FILE *fp, long long *pos, long long to)
+{
+  static char zero[BIN_ALIGN];
+
+  if (to > *pos && fwrite(zero, 1, (size_t)(to - *pos), fp) != (size_t)(to - *pos))
+	return ABORT;
+  *pos = to;
+  return OK;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                       Gwrite_binary                       */
+/*                                                           */
+/*************************************************************/
+int Gwrite_binary(Gauge_complex *gc, char *file)
+{
+  /* Saves 'gc' in GSL binary format (see above) as 'file'.  Record
+	 times are saved as time keys; keys left unset are filled in first
+	 (see Gcheck_gauge_time_keys).
+
+	 Returns: OK, if success.
+	          ABORT, otherwise.
+  */
+  String_table t;
+  Bin_header h;
+  Bin_network *bn = NULL;
+  Bin_gauge *bg = NULL;
+  Gauge_network *gnet;
+  Gauge *g;
+  FILE *fp = NULL;
+  long long pos, off;
+  int i, j, k, ngauge;
+
+  if (gc == NULL || file == NULL) return ABORT;
+  for (i=0; i<gc->h.nnet; i++)
+	for (j=0; j<gc->net[i]->h.ngauge; j++) {
+	  g = gc->net[i]->gauge[j];
+	  if (g == NULL) {
+		fprintf(stderr, "Gwrite_binary: gauge %d of network %s not read.\n",
+				j, gc->net[i]->h.name ? gc->net[i]->h.name : "?");
+		return ABORT;
+	  }
+	  Gcheck_gauge_time_keys(g);
+	}
+  memset(&t, 0, sizeof(t));
+  memset(&h, 0, sizeof(h));
+  for (ngauge=0, i=0; i<gc->h.nnet; i++)
+	ngauge += gc->net[i]->h.ngauge;
+  t.ix = Gnew_index(64);
+  bn = (Bin_network *)calloc(gc->h.nnet+1, sizeof(Bin_network));
+  bg = (Bin_gauge *)calloc(ngauge+1, sizeof(Bin_gauge));
+  if (t.ix == NULL || bn == NULL || bg == NULL) goto fail;
+
+  /* Strings and tables first: they fix the offsets of the blocks. */
+  h.radar_site = string_index(&t, gc->h.radarSite);
+  for (k=0, i=0; i<gc->h.nnet; i++) {
+	gnet = gc->net[i];
+	bn[i].name        = string_index(&t, gnet->h.name);
+	bn[i].location    = string_index(&t, gnet->h.location);
+	bn[i].type        = string_index(&t, gnet->h.type);
+	bn[i].first_gauge = k;
+	bn[i].ngauge      = gnet->h.ngauge;
+	for (j=0; j<gnet->h.ngauge; j++, k++) {
+	  g = gnet->gauge[j];
+	  bg[k].network    = string_index(&t, g->h.network);
+	  bg[k].gv_site    = string_index(&t, g->h.gv_site);
+	  bg[k].product_id = string_index(&t, g->h.product_id);
+	  bg[k].name       = string_index(&t, g->h.name);
+	  bg[k].type       = string_index(&t, g->h.type);
+	  bg[k].radar      = string_index(&t, g->h.radar);
+	  bg[k].number     = g->h.number;
+	  bg[k].nobs       = g->h.nobs;
+	  bg[k].nbin       = g->h.nbin;
+	  bg[k].resolution = g->h.resolution;
+	  bg[k].lat        = g->h.lat;
+	  bg[k].lon        = g->h.lon;
+	  bg[k].azimuth    = g->h.azimuth;
+	  bg[k].range      = g->h.range;
+	  bg[k].elevation  = g->h.elevation;
+	}
+  }
+  if (h.radar_site == -2) goto fail;
+  for (i=0; i<gc->h.nnet; i++)
+	if (bn[i].name == -2 || bn[i].location == -2 || bn[i].type == -2) goto fail;
+  for (k=0; k<ngauge; k++)
+	if (bg[k].network == -2 || bg[k].gv_site == -2 || bg[k].product_id == -2 ||
+		bg[k].name == -2 || bg[k].type == -2 || bg[k].radar == -2) goto fail;
+
+  memcpy(h.magic, BIN_MAGIC, sizeof(h.magic));
+  h.version      = BIN_VERSION;
+  h.byte_order   = BIN_BYTE_ORDER;
+  h.header_size  = sizeof(Bin_header);
+  h.network_size = sizeof(Bin_network);
+  h.gauge_size   = sizeof(Bin_gauge);
+  h.nstring      = t.n;
+  h.nnet         = gc->h.nnet;
+  h.ngauge       = ngauge;
+  h.string_offset  = align(sizeof(Bin_header));
+  h.network_offset = align(h.string_offset + t.n*sizeof(long long) + t.bytes);
+  h.gauge_offset   = align(h.network_offset + gc->h.nnet*sizeof(Bin_network));
+  off = align(h.gauge_offset + ngauge*sizeof(Bin_gauge));
+  for (k=0; k<ngauge; k++) {
+	bg[k].key_offset   = off;
+	off = align(off + (long long)bg[k].nobs*sizeof(Gtime_key));
+	bg[k].value_offset = off;
+	off = align(off + (long long)bg[k].nobs*bg[k].nbin*sizeof(float));
+  }
+  h.file_size = off;
+
+  if ((fp = fopen(file, "wb")) == NULL) {
+	perror(file);
+	goto fail;
+  }
+  pos = 0;
+  if (fwrite(&h, sizeof(h), 1, fp) != 1) goto fail;
+  pos += sizeof(h);
+  if (write_padding(fp, &pos, h.string_offset) != OK) goto fail;
+  for (off=0, i=0; i<t.n; i++) {
+	if (fwrite(&off, sizeof(off), 1, fp) != 1) goto fail;
+	off += strlen(t.s[i]) + 1;
+  }
+  for (i=0; i<t.n; i++)
+	if (fwrite(t.s[i], strlen(t.s[i])+1, 1, fp) != 1) goto fail;
+  pos += t.n*sizeof(long long) + t.bytes;
+  if (write_padding(fp, &pos, h.network_offset) != OK) goto fail;
+  if (gc->h.nnet > 0 && fwrite(bn, sizeof(Bin_network), gc->h.nnet, fp) != (size_t)gc->h.nnet)
+	goto fail;
+  pos += gc->h.nnet*sizeof(Bin_network);
+  if (write_padding(fp, &pos, h.gauge_offset) != OK) goto fail;
+  if (ngauge > 0 && fwrite(bg, sizeof(Bin_gauge), ngauge, fp) != (size_t)ngauge)
+	goto fail;
+  pos += ngauge*sizeof(Bin_gauge);
+
+  for (k=0, i=0; i<gc->h.nnet; i++)
+	for (j=0; j<gc->net[i]->h.ngauge; j++, k++) {
+	  g = gc->net[i]->gauge[j];
+	  if (write_padding(fp, &pos, bg[k].key_offset) != OK) goto fail;
+	  for (off=0; off<g->h.nobs; off++)
+		if (fwrite(&g->record[off].time.key, sizeof(Gtime_key), 1, fp) != 1)
+		  goto fail;
+	  pos += (long long)g->h.nobs*sizeof(Gtime_key);
+	  if (write_padding(fp, &pos, bg[k].value_offset) != OK) goto fail;
+	  for (off=0; off<g->h.nobs; off++)
+		if (g->h.nbin > 0 &&
+			fwrite(g->record[off].value, sizeof(float), g->h.nbin, fp) != (size_t)g->h.nbin)
+		  goto fail;
+	  pos += (long long)g->h.nobs*g->h.nbin*sizeof(float);
+	}
+  if (write_padding(fp, &pos, h.file_size) != OK) goto fail;
+  if (fclose(fp) != 0) {
+	fp = NULL;
+	goto fail;
+  }
+  free(t.s);
+  Gfree_index(t.ix);
+  free(bn);
+  free(bg);
+  return OK;
+
+ fail:
+  fprintf(stderr, "Gwrite_binary: cannot write %s\n", file);
+  if (fp) {
+	fclose(fp);
+	unlink(file);
+  }
+  if (t.s) free(t.s);
+  Gfree_index(t.ix);
+  if (bn) free(bn);
+  if (bg) free(bg);
+  return ABORT;
+}
+
+int Gwrite_binary_gauge(Gauge *g, char *file)
+{
+  /* Saves one gauge, as a complex of one network of one gauge.
+	 Gmap_binary(file)->net[0]->gauge[0] is the gauge.
+  */
+  Gauge_network gnet;
+  Gauge_complex gc;
+  Gauge_network *net[1];
+  Gauge *gauge[1];
+
+  if (g == NULL) return ABORT;
+  memset(&gnet, 0, sizeof(gnet));
+  memset(&gc, 0, sizeof(gc));
+  gauge[0] = g;
+  gnet.gauge = gauge;
+  gnet.h.name = g->h.network;
+  gnet.h.type = g->h.type;
+  gnet.h.ngauge = 1;
+  net[0] = &gnet;
+  gc.net = net;
+  gc.h.radarSite = g->h.gv_site;
+  gc.h.nnet = 1;
+  return Gwrite_binary(&gc, file);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                        Gmap_binary                        */
+/*                                                           */
+/*************************************************************/
+static char *string_at(char *map, Bin_header *h, int j)
+{
+  long long *off = (long long *)(map + h->string_offset);
+
+  if (j < 0 || j >= h->nstring) return NULL;
+  return map + h->string_offset + h->nstring*sizeof(long long) + off[j];
+}
+
+static int fits(long long off, long long n, long long size, long long end)
+{
+  /* Do n items of 'size' bytes starting at 'off' end by 'end'? */
+  if (off < 0 || off > end || n < 0) return 0;
+  return size == 0 || n <= (end - off)/size;
+}
+
+static int valid_binary(char *map, size_t len)
+{
+  /* Does the mapping hold a complete GSL binary file we can read? */
+  Bin_header *h = (Bin_header *)map;
+  Bin_network *bn;
+  Bin_gauge *bg;
+  long long *off, strings;
+  int i;
+
+  if (len < sizeof(Bin_header)) return 0;
+  if (memcmp(h->magic, BIN_MAGIC, sizeof(h->magic)) != 0) return 0;
+  if (h->version != BIN_VERSION || h->byte_order != BIN_BYTE_ORDER ||
+	  h->header_size != sizeof(Bin_header) ||
+	  h->network_size != sizeof(Bin_network) ||
+	  h->gauge_size != sizeof(Bin_gauge)) return 0;
+  if (h->file_size != (long long)len || h->nstring < 0 || h->nnet < 0 ||
+	  h->ngauge < 0) return 0;
+  if (h->string_offset % BIN_ALIGN != 0 || h->network_offset % BIN_ALIGN != 0 ||
+	  h->gauge_offset % BIN_ALIGN != 0) return 0;
+  if (!fits(h->network_offset, h->nnet, (long long)sizeof(Bin_network),
+			h->file_size) ||
+	  !fits(h->gauge_offset, h->ngauge, (long long)sizeof(Bin_gauge),
+			h->file_size) ||
+	  !fits(h->string_offset, h->nstring, (long long)sizeof(long long),
+			h->network_offset))
+	return 0;
+
+  /* Each string starts in the table and is NUL terminated in it. */
+  off = (long long *)(map + h->string_offset);
+  strings = h->string_offset + h->nstring*(long long)sizeof(long long);
+  for (i=0; i<h->nstring; i++)
+	if (off[i] < 0 || off[i] >= h->network_offset - strings ||
+		memchr(map + strings + off[i], '\0',
+			   h->network_offset - strings - off[i]) == NULL) return 0;
+
+  bn = (Bin_network *)(map + h->network_offset);
+  for (i=0; i<h->nnet; i++)
+	if (bn[i].first_gauge < 0 || bn[i].ngauge < 0 ||
+		bn[i].ngauge > MAX_NETWORK_GAUGES ||
+		bn[i].first_gauge + bn[i].ngauge > h->ngauge) return 0;
+  bg = (Bin_gauge *)(map + h->gauge_offset);
+  for (i=0; i<h->ngauge; i++)
+	if (bg[i].nobs < 0 || bg[i].nbin < 0 ||
+		bg[i].key_offset % BIN_ALIGN != 0 || bg[i].value_offset % BIN_ALIGN != 0 ||
+		!fits(bg[i].key_offset, bg[i].nobs, (long long)sizeof(Gtime_key),
+			  h->file_size) ||
+		!fits(bg[i].value_offset, (long long)bg[i].nobs*bg[i].nbin,
+			  (long long)sizeof(float), h->file_size))
+	  return 0;
+  return 1;
+}
+
+Gauge_complex *Gmap_binary(char *file)
+{
+  /* Loads a Gauge_complex saved by Gwrite_binary.  The file is mapped
+	 copy-on-write and the values of the gauges are used in place;
+	 changes to them are not written back.  The complex is an arena
+	 complex (see Gnew_gauge_complex_arena): Gfree_gauge_complex frees
+	 it and unmaps the file.
+
+	 Returns: gauge_complex, if success.
+	          NULL, if the file is missing, not a GSL binary file of
+	                this version, or out of memory.
+  */
+  struct stat sb;
+  Gauge_complex *gc;
+  Gauge_network *gnet;
+  Bin_header *h;
+  Bin_network *bn;
+  Bin_gauge *bg;
+  Gtime_key *key;
+  Gauge *g;
+  Garena *a;
+  char *map;
+  size_t len;
+  int fd, i, j, k, r;
+
+  if (file == NULL) return NULL;
+  if ((fd = open(file, O_RDONLY)) < 0) return NULL;
+  if (fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode) || sb.st_size == 0) {
+	close(fd);
+	return NULL;
+  }
+  len = (size_t)sb.st_size;
+  map = (char *)mmap(NULL, len, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == (char *)MAP_FAILED) return NULL;
+  if (!valid_binary(map, len)) {
+	fprintf(stderr, "Gmap_binary: %s is not a GSL binary file, version %d.\n",
+			file, BIN_VERSION);
+	munmap(map, len);
+	return NULL;
+  }
+  h  = (Bin_header *)map;
+  bn = (Bin_network *)(map + h->network_offset);
+  bg = (Bin_gauge *)(map + h->gauge_offset);
+
+  gc = Gnew_gauge_complex_arena(h->nnet > MAX_GAUGE_NETWORKS ? h->nnet : MAX_GAUGE_NETWORKS);
+  if (gc == NULL) {
+	munmap(map, len);
+	return NULL;
+  }
+  gc->map = map;
+  gc->map_len = len;
+  a = gc->arena;
+  gc->h.radarSite = Gintern(string_at(map, h, h->radar_site));
+
+  for (i=0; i<h->nnet; i++) {
+	gnet = (Gauge_network *)Garena_alloc(a, sizeof(Gauge_network));
+	if (gnet == NULL) goto fail;
+	gnet->arena = a;
+	gnet->gauge = (Gauge **)Garena_alloc(a, (MAX_NETWORK_GAUGES+1)*sizeof(Gauge *));
+	if (gnet->gauge == NULL) goto fail;
+	gnet->h.name     = Gintern(string_at(map, h, bn[i].name));
+	gnet->h.location = Gintern(string_at(map, h, bn[i].location));
+	gnet->h.type     = Gintern(string_at(map, h, bn[i].type));
+	for (j=0; j<bn[i].ngauge; j++) {
+	  k = bn[i].first_gauge + j;
+	  g = (Gauge *)Garena_alloc(a, sizeof(Gauge));
+	  if (g == NULL) goto fail;
+	  g->arena = a;
+	  g->h.network    = Gintern(string_at(map, h, bg[k].network));
+	  g->h.gv_site    = Gintern(string_at(map, h, bg[k].gv_site));
+	  g->h.product_id = Gintern(string_at(map, h, bg[k].product_id));
+	  g->h.name       = Garena_strdup(a, string_at(map, h, bg[k].name));
+	  g->h.type       = Gintern(string_at(map, h, bg[k].type));
+	  g->h.radar      = Gintern(string_at(map, h, bg[k].radar));
+	  g->h.number     = bg[k].number;
+	  g->h.nobs       = bg[k].nobs;
+	  g->h.nbin       = bg[k].nbin;
+	  g->h.resolution = bg[k].resolution;
+	  g->h.lat        = bg[k].lat;
+	  g->h.lon        = bg[k].lon;
+	  g->h.azimuth    = bg[k].azimuth;
+	  g->h.range      = bg[k].range;
+	  g->h.elevation  = bg[k].elevation;
+	  g->record = (Gauge_record *)Garena_alloc(a, (g->h.nobs+1)*sizeof(Gauge_record));
+	  if (g->record == NULL) goto fail;
+	  key = (Gtime_key *)(map + bg[k].key_offset);
+	  g->record->value = (float *)(map + bg[k].value_offset);
+	  for (r=0; r<g->h.nobs; r++) {
+		Gkey_to_time(key[r], &g->record[r].time);
+		g->record[r].value = g->record->value + r*g->h.nbin;
+	  }
+	  gnet->gauge[gnet->h.ngauge++] = g;
+	}
+	gc->net[gc->h.nnet++] = gnet;
+  }
+  if (Gindex_gauge_complex(gc) != OK) goto fail;
+  return gc;
+
+ fail:
+  perror("Gmap_binary");
+  Gfree_gauge_complex(gc);
+  return NULL;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                    Gbinary_is_current                     */
+/*                                                           */
+/*************************************************************/
+int Gbinary_is_current(char *binfile, int nfile, char **file)
+{
+  /* Nonzero if 'binfile' exists and is newer than each of
+	 file[0..nfile-1], i.e. Gmap_binary(binfile) can stand in for
+	 reading them.
+  */
+  struct stat bin, sb;
+  int j;
+
+  if (binfile == NULL || stat(binfile, &bin) != 0) return 0;
+  for (j=0; j<nfile; j++)
+	if (stat(file[j], &sb) != 0 || sb.st_mtime >= bin.st_mtime) return 0;
+  return 1;
+}
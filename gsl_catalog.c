@@ -0,0 +1,305 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************
+
+	The radar site catalog: Fisher's database file 'radar.dat', read
+	once and indexed by gauge network name and by radar id.
+
+	Each non-comment line of 'radar.dat' is
+
+	    gv_site  network  radar  radar_lat  radar_lon
+
+	Lines starting with '#' are comments.  One radar usually appears
+	on several lines, once per gauge network it covers.
+
+	Catalogs are cached per file, so every lookup after the first one
+	for a given 'radar.dat' is a hash probe.
+
+*******************************************************************/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
+#include "gsl.h"
+
+#define DEFAULT_RADAR_CATALOG "/usr/local/trmm/GVBOX/data/sitelist/radar.dat"
+
+static char *catalog_path = NULL;  /* NULL: DEFAULT_RADAR_CATALOG */
+
+/* Catalogs loaded so far, one per file. */
+typedef struct Catalog_cache {
+  Gradar_catalog       *cat;
+  struct Catalog_cache *next;
+} Catalog_cache;
+static Catalog_cache *cache = NULL;
+#ifdef HAVE_LIBPTHREAD
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+typedef struct {
+  Gradar_catalog *cat;
+  char           *key;
+} Catalog_key;
+
+static int same_network(int j, void *arg)
+{
+  Catalog_key *k = (Catalog_key *)arg;
+  return strcmp(k->cat->entry[j].network, k->key) == 0;
+}
+
+static int same_radar(int j, void *arg)
+{
+  Catalog_key *k = (Catalog_key *)arg;
+  return strcmp(k->cat->entry[j].radar, k->key) == 0;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                   Gload_radar_catalog                     */
+/*                                                           */
+/*************************************************************/
+Gradar_catalog *Gload_radar_catalog(char *path)
+{
+  /* Reads and indexes the radar site database file 'path'.  The
+	 result is private to the caller; see Gradar_catalog_for for the
+	 shared, cached copy.
+
+	 Returns: catalog, if success.
+	          NULL, otherwise.
+  */
+  FILE *fp;
+  Gradar_catalog *cat;
+  Gradar_entry *e;
+  Catalog_key key;
+  char line[1000];
+  char gv_site[32], network[32], radar[32];
+  float lat, lon;
+  int j, n, maxentry;
+
+  if (path == NULL) return NULL;
+  if ((fp = fopen(path, "r")) == NULL) {
+	fprintf(stderr, "Error opening database file: %s\n", path);
+	return NULL;
+  }
+  cat = (Gradar_catalog *)calloc(1, sizeof(Gradar_catalog));
+  if (cat == NULL) {
+	perror("Gload_radar_catalog");
+	fclose(fp);
+	return NULL;
+  }
+  cat->path = (char *)strdup(path);
+  maxentry = 64;
+  cat->entry = (Gradar_entry *)calloc(maxentry, sizeof(Gradar_entry));
+  cat->by_network = Gnew_index(maxentry);
+  cat->by_radar   = Gnew_index(maxentry);
+  if (cat->entry == NULL || cat->by_network == NULL || cat->by_radar == NULL)
+	goto fail;
+
+  while (fgets(line, sizeof(line), fp) != NULL) {
+	if (line[0] == '#') continue; /* Skip commented lines. */
+	lat = lon = 0.0;
+	n = sscanf(line, "%31s %31s %31s %f %f", gv_site, network, radar,
+			   &lat, &lon);
+	if (n < 3) continue;
+	if (cat->nentry == maxentry) {
+	  maxentry *= 2;
+	  e = (Gradar_entry *)realloc(cat->entry, maxentry*sizeof(Gradar_entry));
+	  if (e == NULL) goto fail;
+	  cat->entry = e;
+	}
+	e = &cat->entry[cat->nentry];
+	e->gv_site = (char *)strdup(gv_site);
+	e->network = (char *)strdup(network);
+	e->radar   = (char *)strdup(radar);
+	e->lat = lat;
+	e->lon = lon;
+	e->next_in_radar = -1;
+	cat->nentry++;
+
+	/* The first line for a network wins, as it did for the linear scan. */
+	key.cat = cat;
+	key.key = network;
+	if (Gindex_find(cat->by_network, Ghash_string(network),
+					same_network, &key) < 0 &&
+		Gindex_add(cat->by_network, Ghash_string(network),
+				   cat->nentry-1) != OK)
+	  goto fail;
+
+	/* Lines of the same radar are chained in file order. */
+	key.key = radar;
+	j = Gindex_find(cat->by_radar, Ghash_string(radar), same_radar, &key);
+	if (j < 0) {
+	  if (Gindex_add(cat->by_radar, Ghash_string(radar), cat->nentry-1) != OK)
+		goto fail;
+	} else {
+	  while (cat->entry[j].next_in_radar >= 0) j = cat->entry[j].next_in_radar;
+	  cat->entry[j].next_in_radar = cat->nentry-1;
+	}
+  }
+  fclose(fp);
+  return cat;
+
+ fail:
+  perror("Gload_radar_catalog");
+  fclose(fp);
+  Gfree_radar_catalog(cat);
+  return NULL;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                   Gfree_radar_catalog                     */
+/*                                                           */
+/*************************************************************/
+void Gfree_radar_catalog(Gradar_catalog *cat)
+{
+  /* Only for catalogs from Gload_radar_catalog.  Cached catalogs
+	 (Gradar_catalog_for) live until the process exits. */
+  int j;
+
+  if (cat == NULL) return;
+  for (j=0; j<cat->nentry; j++) {
+	free(cat->entry[j].gv_site);
+	free(cat->entry[j].network);
+	free(cat->entry[j].radar);
+  }
+  if (cat->entry) free(cat->entry);
+  Gfree_index(cat->by_network);
+  Gfree_index(cat->by_radar);
+  if (cat->path) free(cat->path);
+  free(cat);
+}
+
+/*************************************************************/
+/*                                                           */
+/*          Gset_radar_catalog_path / Gradar_catalog_path    */
+/*                                                           */
+/*************************************************************/
+void Gset_radar_catalog_path(char *path)
+{
+  /* Sets the 'radar.dat' used by find_gauge_radarSite and
+	 Gconstruct_gauge_complex.  NULL restores the default,
+	 /usr/local/trmm/GVBOX/data/sitelist/radar.dat.
+  */
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_lock(&cache_lock);
+#endif
+  if (catalog_path) free(catalog_path);
+  catalog_path = (path == NULL) ? NULL : (char *)strdup(path);
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_unlock(&cache_lock);
+#endif
+}
+
+char *Gradar_catalog_path(void)
+{
+  return (catalog_path == NULL) ? DEFAULT_RADAR_CATALOG : catalog_path;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                   Gradar_catalog_for                      */
+/*                                                           */
+/*************************************************************/
+Gradar_catalog *Gradar_catalog_for(char *path)
+{
+  /* The shared catalog for database file 'path' (NULL: the file set
+	 by Gset_radar_catalog_path).  The file is read the first time it
+	 is asked for; later calls return the same catalog.  Do not free it.
+
+	 Returns: catalog, if success.
+	          NULL, if the file cannot be read.
+  */
+  Catalog_cache *c;
+  Gradar_catalog *cat = NULL;
+
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_lock(&cache_lock);
+#endif
+  if (path == NULL) path = Gradar_catalog_path();
+  for (c = cache; c != NULL; c = c->next)
+	if (strcmp(c->cat->path, path) == 0) {
+	  cat = c->cat;
+	  break;
+	}
+  if (cat == NULL && (cat = Gload_radar_catalog(path)) != NULL) {
+	c = (Catalog_cache *)calloc(1, sizeof(Catalog_cache));
+	if (c == NULL) {
+	  Gfree_radar_catalog(cat);
+	  cat = NULL;
+	} else {
+	  c->cat  = cat;
+	  c->next = cache;
+	  cache   = c;
+	}
+  }
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_unlock(&cache_lock);
+#endif
+  return cat;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                 Gfind_radar_by_network                    */
+/*                                                           */
+/*************************************************************/
+Gradar_entry *Gfind_radar_by_network(Gradar_catalog *cat, char *netName)
+{
+  /* The catalog entry of gauge network 'netName', or NULL. */
+  Catalog_key key;
+  int j;
+
+  if (cat == NULL || netName == NULL) return NULL;
+  key.cat = cat;
+  key.key = netName;
+  j = Gindex_find(cat->by_network, Ghash_string(netName), same_network, &key);
+  return (j < 0) ? NULL : &cat->entry[j];
+}
+
+/*************************************************************/
+/*                                                           */
+/*                   Gfind_radar_entries                     */
+/*                                                           */
+/*************************************************************/
+Gradar_entry *Gfind_radar_entries(Gradar_catalog *cat, char *radar_id)
+{
+  /* The first catalog entry of radar 'radar_id', or NULL.  The other
+	 entries of the same radar follow in file order via
+	 'next_in_radar' (an index into cat->entry, -1 at the end).
+  */
+  Catalog_key key;
+  int j;
+
+  if (cat == NULL || radar_id == NULL) return NULL;
+  key.cat = cat;
+  key.key = radar_id;
+  j = Gindex_find(cat->by_radar, Ghash_string(radar_id), same_radar, &key);
+  return (j < 0) ? NULL : &cat->entry[j];
+}
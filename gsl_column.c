@@ -0,0 +1,240 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************
+
+	Columnar copies of gauges and gauge networks.
+
+	A 'Gauge_columns' holds the observations of one or more gauges as
+	two plain arrays: the time keys of all records, gauge after gauge,
+	and a dense matrix with 'nbin' values per record.  The records of
+	gauge i are rows start[i] .. start[i+1]-1.  Scans over rain rates
+	then run over contiguous floats instead of following one value
+	pointer per record.  See the Gcolumn_* macros in gsl.h.
+
+*******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gsl.h"
+
+static char *copy_string(char *s)
+{
+  return (s == NULL) ? NULL : (char *)strdup(s);
+}
+
+static void copy_header_strings(Gauge_header *h)
+{
+  h->name       = copy_string(h->name);
+  h->network    = Gintern(h->network);
+  h->gv_site    = Gintern(h->gv_site);
+  h->product_id = Gintern(h->product_id);
+  h->type       = Gintern(h->type);
+  h->radar      = Gintern(h->radar);
+}
+
+static void free_header_strings(Gauge_header *h)
+{
+  if (h->name) free(h->name);
+}
+
+/*************************************************************/
+/*                                                           */
+/*          Ggauge_to_columns / Gnetwork_to_columns          */
+/*                                                           */
+/*************************************************************/
+static Gauge_columns *gauges_to_columns(Gauge **gauge, int ngauge)
+{
+  Gauge_columns *c;
+  Gauge *g;
+  int i, j, row, nbin;
+
+  c = (Gauge_columns *)calloc(1, sizeof(Gauge_columns));
+  if (c == NULL) {
+	perror("Gauge_columns");
+	return NULL;
+  }
+  c->ngauge = ngauge;
+  c->h     = (Gauge_header *)calloc(ngauge+1, sizeof(Gauge_header));
+  c->start = (int *)calloc(ngauge+1, sizeof(int));
+  if (c->h == NULL || c->start == NULL) goto fail;
+
+  /* The matrix is as wide as the widest gauge; narrower gauges are
+   * padded with zeros.
+   */
+  c->nbin = 1;
+  for (i=0; i<ngauge; i++) {
+	g = gauge[i];
+	c->start[i] = c->nrow;
+	if (g == NULL) continue;
+	Gcheck_gauge_time_keys(g);
+	c->h[i] = g->h;
+	copy_header_strings(&c->h[i]);
+	c->nrow += g->h.nobs;
+	if (g->h.nbin > c->nbin) c->nbin = g->h.nbin;
+  }
+  c->start[ngauge] = c->nrow;
+
+  c->key   = (Gtime_key *)malloc((c->nrow+1)*sizeof(Gtime_key));
+  c->value = (float *)calloc((c->nrow+1)*c->nbin, sizeof(float));
+  if (c->key == NULL || c->value == NULL) goto fail;
+
+  for (i=0; i<ngauge; i++) {
+	if ((g = gauge[i]) == NULL) continue;
+	nbin = (g->h.nbin < c->nbin) ? g->h.nbin : c->nbin;
+	for (j=0, row=c->start[i]; j<g->h.nobs; j++, row++) {
+	  c->key[row] = g->record[j].time.key;
+	  memcpy(c->value + row*c->nbin, g->record[j].value, nbin*sizeof(float));
+	}
+  }
+  return c;
+
+ fail:
+  perror("Gauge_columns");
+  Gfree_columns(c);
+  return NULL;
+}
+
+Gauge_columns *Ggauge_to_columns(Gauge *g)
+{
+  /* Columnar copy of one gauge.  'g' is not changed.
+
+	 Returns: columns, if success.  Free with Gfree_columns.
+	          NULL, otherwise.
+  */
+  if (g == NULL) return NULL;
+  return gauges_to_columns(&g, 1);
+}
+
+Gauge_columns *Gnetwork_to_columns(Gauge_network *gnet)
+{
+  /* Columnar copy of all gauges of 'gnet', in network order: column
+	 gauge i is gnet->gauge[i].  The network header is kept too, so
+	 Gcolumns_to_network gives back an equivalent network.
+
+	 Returns: columns, if success.  Free with Gfree_columns.
+	          NULL, otherwise.
+  */
+  Gauge_columns *c;
+
+  if (gnet == NULL) return NULL;
+  c = gauges_to_columns(gnet->gauge, gnet->h.ngauge);
+  if (c == NULL) return NULL;
+  c->nh = gnet->h;
+  c->nh.name     = Gintern(gnet->h.name);
+  c->nh.location = Gintern(gnet->h.location);
+  c->nh.type     = Gintern(gnet->h.type);
+  return c;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                   Gcolumns_to_gauge                       */
+/*                                                           */
+/*************************************************************/
+Gauge *Gcolumns_to_gauge(Gauge_columns *c, int i)
+{
+  /* A new Gauge holding column gauge i (0..c->ngauge-1).  Record
+	 times are rebuilt from the keys (see Gkey_to_time).
+
+	 Returns: gauge, if success.
+	          NULL, otherwise.
+  */
+  Gauge *g;
+  int j, n, nbin, row;
+
+  if (c == NULL || i < 0 || i >= c->ngauge) return NULL;
+  n    = Gcolumn_nrow(c, i);
+  nbin = c->h[i].nbin;
+  if (nbin <= 0 || nbin > c->nbin) nbin = c->nbin;
+  g = Gnew_gauge(n > 0 ? n : 1, nbin);
+  if (g == NULL || g->record == NULL || g->record->value == NULL) {
+	Gfree_gauge(g);
+	return NULL;
+  }
+  g->h = c->h[i];
+  copy_header_strings(&g->h);
+  g->h.nobs = n;
+  g->h.nbin = nbin;
+  for (j=0, row=c->start[i]; j<n; j++, row++) {
+	Gkey_to_time(c->key[row], &g->record[j].time);
+	memcpy(g->record[j].value, c->value + row*c->nbin, nbin*sizeof(float));
+  }
+  return g;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                  Gcolumns_to_network                      */
+/*                                                           */
+/*************************************************************/
+Gauge_network *Gcolumns_to_network(Gauge_columns *c)
+{
+  /* A new Gauge_network with one gauge per column gauge.
+
+	 Returns: network, if success.
+	          NULL, otherwise.
+  */
+  Gauge_network *gnet;
+  int i;
+
+  if (c == NULL) return NULL;
+  gnet = Gnew_gauge_network(c->ngauge > 0 ? c->ngauge : 1);
+  if (gnet == NULL) return NULL;
+  gnet->h = c->nh;
+  gnet->h.ngauge = 0;
+  for (i=0; i<c->ngauge; i++) {
+	gnet->gauge[i] = Gcolumns_to_gauge(c, i);
+	if (gnet->gauge[i] == NULL) {
+	  Gfree_gauge_network(gnet);
+	  return NULL;
+	}
+	gnet->h.ngauge++;
+  }
+  if (Gindex_gauge_network(gnet) != OK) {
+	Gfree_gauge_network(gnet);
+	return NULL;
+  }
+  return gnet;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                      Gfree_columns                        */
+/*                                                           */
+/*************************************************************/
+void Gfree_columns(Gauge_columns *c)
+{
+  int i;
+
+  if (c == NULL) return;
+  if (c->h) {
+	for (i=0; i<c->ngauge; i++)
+	  free_header_strings(&c->h[i]);
+	free(c->h);
+  }
+  if (c->start) free(c->start);
+  if (c->key) free(c->key);
+  if (c->value) free(c->value);
+  free(c);
+}
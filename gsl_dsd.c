@@ -0,0 +1,274 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************
+
+	Drop size distribution moments of disdrometer records.
+
+	A disdrometer record holds the number of drops counted in each of
+	the 20 size classes of a Joss-Waldvogel RD-69 during h.resolution
+	minutes, on a 50 cm^2 sampling area.  With D the class diameter
+	(mm), dD its width (mm), v(D) = 9.65 - 10.3 exp(-0.6 D) the fall
+	speed (m/s, Atlas et al. 1973), n the count, A the area (m^2) and
+	T the sampling time (s), the concentration is
+
+	    N(D) = n / (A T v(D) dD)                   [m^-3 mm^-1]
+
+	and
+
+	    R   = 6 pi 1e-4 sum n D^3 / (A T)          [mm/hr]
+	    Z   = sum n D^6 / (A T v)                  [mm^6 m^-3]
+	    W   = pi/6 1e-3 sum n D^3 / (A T v)        [g m^-3]
+	    Dm  = sum n D^4 / v  /  sum n D^3 / v      [mm]
+	    D0: half the water volume is in drops smaller than D0 [mm]
+
+	Everything except D0 is a dot product of the 20 counts with a
+	fixed weight vector; the weights are computed once and the dot
+	products done four bins at a time with SSE.
+
+*******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "gsl.h"
+
+#define DSD_AREA 0.005   /* Sampling area, m^2. */
+
+/* RD-69 size classes: mean diameter and width, mm. */
+static float dsd_diameter[GSL_DSD_NBIN] = {
+  0.359, 0.455, 0.551, 0.656, 0.771, 0.913, 1.116, 1.331, 1.506, 1.665,
+  1.912, 2.259, 2.584, 2.869, 3.198, 3.544, 3.916, 4.350, 4.859, 5.373
+};
+static float dsd_width[GSL_DSD_NBIN] = {
+  0.092, 0.100, 0.091, 0.119, 0.112, 0.172, 0.233, 0.197, 0.153, 0.166,
+  0.329, 0.364, 0.286, 0.284, 0.374, 0.319, 0.423, 0.446, 0.572, 0.455
+};
+
+/* Weights, one per bin; see the formulas above. */
+typedef struct {
+  float r[GSL_DSD_NBIN];   /* 6 pi 1e-4 D^3 / A       */
+  float z[GSL_DSD_NBIN];   /* D^6 / (A v)             */
+  float w[GSL_DSD_NBIN];   /* pi/6 1e-3 D^3 / (A v)   */
+  float m3[GSL_DSD_NBIN];  /* D^3 / v                 */
+  float m4[GSL_DSD_NBIN];  /* D^4 / v                 */
+} Dsd_weights;
+
+static Dsd_weights weights;
+static int weights_ready = 0;
+
+static void make_weights(void)
+{
+  double d, v, d3;
+  int i;
+
+  for (i=0; i<GSL_DSD_NBIN; i++) {
+	d  = dsd_diameter[i];
+	v  = 9.65 - 10.3*exp(-0.6*d);
+	d3 = d*d*d;
+	weights.r[i]  = 6*M_PI*1e-4*d3/DSD_AREA;
+	weights.z[i]  = d3*d3/(DSD_AREA*v);
+	weights.w[i]  = M_PI/6*1e-3*d3/(DSD_AREA*v);
+	weights.m3[i] = d3/v;
+	weights.m4[i] = d3*d/v;
+  }
+  weights_ready = 1;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                     Gdsd_bin_size                         */
+/*                                                           */
+/*************************************************************/
+int Gdsd_bin_size(int bin, float *diameter, float *width, float *velocity)
+{
+  /* The mean diameter (mm), class width (mm) and fall speed (m/s) of
+	 size class 'bin' (0..GSL_DSD_NBIN-1).  Any pointer may be NULL.
+
+	 Returns: OK, or ABORT if there is no such class.
+  */
+  if (bin < 0 || bin >= GSL_DSD_NBIN) return ABORT;
+  if (diameter) *diameter = dsd_diameter[bin];
+  if (width)    *width    = dsd_width[bin];
+  if (velocity) *velocity = 9.65 - 10.3*exp(-0.6*dsd_diameter[bin]);
+  return OK;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                      record moments                       */
+/*                                                           */
+/*************************************************************/
+static float median_volume_diameter(float *n)
+{
+  /* D0, interpolating linearly within the class that holds the
+   * median of the water volume.
+   */
+  float vol[GSL_DSD_NBIN], total, half, below, lo;
+  int i;
+
+  for (total=0, i=0; i<GSL_DSD_NBIN; i++) {
+	vol[i] = (n[i] > 0) ? n[i]*weights.m3[i] : 0;
+	total += vol[i];
+  }
+  if (total <= 0) return 0;
+  half = total/2;
+  for (below=0, i=0; i<GSL_DSD_NBIN; i++) {
+	if (below + vol[i] >= half) {
+	  lo = dsd_diameter[i] - dsd_width[i]/2;
+	  return lo + dsd_width[i]*(half - below)/vol[i];
+	}
+	below += vol[i];
+  }
+  return dsd_diameter[GSL_DSD_NBIN-1];
+}
+
+static void record_moments(float *n, float seconds, Gdsd_moments *m)
+{
+  float r, z, w, m3, m4;
+  int i;
+#ifdef __SSE2__
+  __m128 x, sr, sz, sw, s3, s4;
+  float part[4];
+
+  sr = sz = sw = s3 = s4 = _mm_setzero_ps();
+  for (i=0; i<GSL_DSD_NBIN; i+=4) {
+	x  = _mm_loadu_ps(n+i);
+	sr = _mm_add_ps(sr, _mm_mul_ps(x, _mm_loadu_ps(weights.r+i)));
+	sz = _mm_add_ps(sz, _mm_mul_ps(x, _mm_loadu_ps(weights.z+i)));
+	sw = _mm_add_ps(sw, _mm_mul_ps(x, _mm_loadu_ps(weights.w+i)));
+	s3 = _mm_add_ps(s3, _mm_mul_ps(x, _mm_loadu_ps(weights.m3+i)));
+	s4 = _mm_add_ps(s4, _mm_mul_ps(x, _mm_loadu_ps(weights.m4+i)));
+  }
+#define HSUM(s) (_mm_storeu_ps(part, s), (part[0]+part[1])+(part[2]+part[3]))
+  r  = HSUM(sr);
+  z  = HSUM(sz);
+  w  = HSUM(sw);
+  m3 = HSUM(s3);
+  m4 = HSUM(s4);
+#undef HSUM
+#else
+  r = z = w = m3 = m4 = 0;
+  for (i=0; i<GSL_DSD_NBIN; i++) {
+	r  += n[i]*weights.r[i];
+	z  += n[i]*weights.z[i];
+	w  += n[i]*weights.w[i];
+	m3 += n[i]*weights.m3[i];
+	m4 += n[i]*weights.m4[i];
+  }
+#endif
+  m->rain_rate = r/seconds;
+  m->z   = z/seconds;
+  m->dbz = (m->z > 0) ? 10*log10(m->z) : GSL_DSD_NO_DBZ;
+  m->lwc = w/seconds;
+  m->dm  = (m3 > 0) ? m4/m3 : 0;
+  m->d0  = median_volume_diameter(n);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                    Gdsd_moments_gauge                     */
+/*                                                           */
+/*************************************************************/
+int Gdsd_moments_gauge(Gauge *g, Gdsd_moments *m)
+{
+  /* Fills m[0..nobs-1] with the rain rate, reflectivity, liquid water
+	 content, Dm and D0 of each record of disdrometer 'g'.  Records
+	 without drops give zeros (dbz = GSL_DSD_NO_DBZ).
+
+	 Returns: OK, if success.
+	          ABORT, if 'g' is not a disdrometer (nbin != GSL_DSD_NBIN).
+  */
+  float seconds;
+  int j;
+
+  if (g == NULL || m == NULL) return ABORT;
+  if (g->h.nbin != GSL_DSD_NBIN) {
+	fprintf(stderr, "Gdsd_moments_gauge: %s is not a disdrometer.\n",
+			g->h.name ? g->h.name : "gauge");
+	return ABORT;
+  }
+  if (!weights_ready) make_weights();
+  seconds = 60*((g->h.resolution > 0) ? g->h.resolution : 1.0);
+  for (j=0; j<g->h.nobs; j++)
+	record_moments(g->record[j].value, seconds, &m[j]);
+  return OK;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                   Gdsd_moments_network                    */
+/*                                                           */
+/*************************************************************/
+int Gdsd_moments_network(Gauge_network *gnet, Gdsd_moments *m)
+{
+  /* Gdsd_moments_gauge for all disdrometers of 'gnet'.  The records
+	 of gauge 0 go first, then those of gauge 1, and so on (the row
+	 order of Gnetwork_to_columns).  'm' must have room for the
+	 records of all gauges.
+
+	 Returns: OK, if success.
+	          ABORT, if a gauge is not a disdrometer.
+  */
+  int i;
+
+  if (gnet == NULL || m == NULL) return ABORT;
+  for (i=0; i<gnet->h.ngauge; i++) {
+	if (gnet->gauge[i] == NULL) continue;
+	if (Gdsd_moments_gauge(gnet->gauge[i], m) != OK) return ABORT;
+	m += gnet->gauge[i]->h.nobs;
+  }
+  return OK;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                   Gdsd_moments_columns                    */
+/*                                                           */
+/*************************************************************/
+int Gdsd_moments_columns(Gauge_columns *c, Gdsd_moments *m)
+{
+  /* Fills m[0..c->nrow-1], one per row of a disdrometer Gauge_columns.
+
+	 Returns: OK, if success.
+	          ABORT, if the rows are not GSL_DSD_NBIN wide.
+  */
+  float seconds;
+  int i, row;
+
+  if (c == NULL || m == NULL) return ABORT;
+  if (c->nbin != GSL_DSD_NBIN) {
+	fprintf(stderr, "Gdsd_moments_columns: not disdrometer data.\n");
+	return ABORT;
+  }
+  if (!weights_ready) make_weights();
+  for (i=0; i<c->ngauge; i++) {
+	seconds = 60*((c->h[i].resolution > 0) ? c->h[i].resolution : 1.0);
+	for (row=c->start[i]; row<c->start[i+1]; row++)
+	  record_moments(c->value + row*GSL_DSD_NBIN, seconds, &m[row]);
+  }
+  return OK;
+}
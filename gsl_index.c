@@ -0,0 +1,201 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************
+
+	Hash index used for the GSL lookup tables.
+
+	A 'Gindex' maps a key's hash to a small integer -- normally the
+	position of the keyed object in some array the caller owns.  The
+	index never sees the keys themselves: lookups pass a 'same'
+	function that compares the wanted key with a candidate entry,
+	so one index type serves string keys, gauge numbers, etc.
+
+	Open addressing with linear probing; the table doubles whenever
+	it becomes half full.
+
+*******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "gsl.h"
+
+/*************************************************************/
+/*                                                           */
+/*                 Ghash_string / Ghash_int                  */
+/*                                                           */
+/*************************************************************/
+unsigned int Ghash_string(char *s)
+{
+  /* FNV-1a. */
+  unsigned int h = 2166136261U;
+
+  if (s == NULL) return h;
+  while (*s) {
+	h ^= (unsigned char)*s++;
+	h *= 16777619U;
+  }
+  return h;
+}
+
+unsigned int Ghash_int(int n)
+{
+  unsigned int h = (unsigned int)n;
+
+  h ^= h >> 16;
+  h *= 0x85ebca6bU;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35U;
+  h ^= h >> 16;
+  return h;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                  Gnew_index / Gfree_index                 */
+/*                                                           */
+/*************************************************************/
+Gindex *Gnew_index(int nkey)
+{
+  /* An empty index with room for 'nkey' keys before it must grow. */
+  Gindex *ix;
+  int j;
+
+  ix = (Gindex *)calloc(1, sizeof(Gindex));
+  if (ix == NULL) {
+	perror("Gnew_index");
+	return NULL;
+  }
+  for (ix->nslot = 16; ix->nslot < 2*nkey; ix->nslot *= 2)
+	continue;
+  ix->hash  = (unsigned int *)calloc(ix->nslot, sizeof(unsigned int));
+  ix->value = (int *)malloc(ix->nslot*sizeof(int));
+  if (ix->hash == NULL || ix->value == NULL) {
+	perror("Gnew_index -- slots");
+	Gfree_index(ix);
+	return NULL;
+  }
+  for (j=0; j<ix->nslot; j++) ix->value[j] = -1;
+  return ix;
+}
+
+void Gfree_index(Gindex *ix)
+{
+  if (ix == NULL) return;
+  if (ix->hash) free(ix->hash);
+  if (ix->value) free(ix->value);
+  free(ix);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                       Gclear_index                        */
+/*                                                           */
+/*************************************************************/
+void Gclear_index(Gindex *ix)
+{
+  int j;
+
+  if (ix == NULL) return;
+  for (j=0; j<ix->nslot; j++) ix->value[j] = -1;
+  ix->nkey = 0;
+}
+
+static int grow_index(Gindex *ix)
+{
+  unsigned int *hash;
+  int *value;
+  int j, k, nslot, mask;
+
+  nslot = 2*ix->nslot;
+  mask  = nslot - 1;
+  hash  = (unsigned int *)calloc(nslot, sizeof(unsigned int));
+  value = (int *)malloc(nslot*sizeof(int));
+  if (hash == NULL || value == NULL) {
+	perror("Gindex_add -- growing");
+	if (hash) free(hash);
+	if (value) free(value);
+	return ABORT;
+  }
+  for (k=0; k<nslot; k++) value[k] = -1;
+  for (j=0; j<ix->nslot; j++) {
+	if (ix->value[j] < 0) continue;
+	for (k = ix->hash[j] & mask; value[k] >= 0; k = (k+1) & mask)
+	  continue;
+	hash[k]  = ix->hash[j];
+	value[k] = ix->value[j];
+  }
+  free(ix->hash);
+  free(ix->value);
+  ix->hash  = hash;
+  ix->value = value;
+  ix->nslot = nslot;
+  return OK;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                        Gindex_add                         */
+/*                                                           */
+/*************************************************************/
+int Gindex_add(Gindex *ix, unsigned int hash, int value)
+{
+  /* Enter 'value' (>= 0) under 'hash'.  Duplicate keys are not
+	 checked for; callers that want unique keys look them up first.
+
+	 Returns: OK, if success.
+	          ABORT, if out of memory.
+  */
+  int k, mask;
+
+  if (ix == NULL || value < 0) return ABORT;
+  if (2*(ix->nkey+1) > ix->nslot && grow_index(ix) != OK) return ABORT;
+  mask = ix->nslot - 1;
+  for (k = hash & mask; ix->value[k] >= 0; k = (k+1) & mask)
+	continue;
+  ix->hash[k]  = hash;
+  ix->value[k] = value;
+  ix->nkey++;
+  return OK;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                        Gindex_find                        */
+/*                                                           */
+/*************************************************************/
+int Gindex_find(Gindex *ix, unsigned int hash,
+				int (*same)(int value, void *arg), void *arg)
+{
+  /* Returns a value entered under 'hash' for which same(value, arg)
+	 is nonzero, or -1 if there is none.  'arg' carries whatever
+	 'same' needs to compare: the wanted key, the caller's array, ...
+  */
+  int k, mask;
+
+  if (ix == NULL) return -1;
+  mask = ix->nslot - 1;
+  for (k = hash & mask; ix->value[k] >= 0; k = (k+1) & mask)
+	if (ix->hash[k] == hash && same(ix->value[k], arg))
+	  return ix->value[k];
+  return -1;
+}
@@ -0,0 +1,111 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************
+
+	Interned strings.
+
+	The header strings that many gauges have in common -- network,
+	gv_site, product_id, type, radar -- as well as network names and
+	types and the radar site of a complex, point into one process wide
+	table: equal strings are the same pointer.  They are never freed
+	and must not be modified.
+
+	The table is shared by all threads.
+
+*******************************************************************/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
+#include "gsl.h"
+
+static Garena  *strings = NULL;  /* The characters. */
+static char   **string  = NULL;  /* string[0..nstring-1] */
+static int      nstring = 0;
+static int      maxstring = 0;
+static Gindex  *table   = NULL;
+#ifdef HAVE_LIBPTHREAD
+static pthread_mutex_t intern_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static int same_string(int j, void *arg)
+{
+  return strcmp(string[j], (char *)arg) == 0;
+}
+
+static char *intern(char *s)
+{
+  unsigned int hash;
+  char **new_string;
+  int j;
+
+  hash = Ghash_string(s);
+  j = Gindex_find(table, hash, same_string, s);
+  if (j >= 0) return string[j];
+
+  if (table == NULL) {
+	if ((table = Gnew_index(256)) == NULL) return NULL;
+	if ((strings = Gnew_arena(16*1024)) == NULL) return NULL;
+  }
+  if (nstring == maxstring) {
+	new_string = (char **)realloc(string, (2*maxstring+256)*sizeof(char *));
+	if (new_string == NULL) return NULL;
+	string = new_string;
+	maxstring = 2*maxstring+256;
+  }
+  if ((string[nstring] = Garena_strdup(strings, s)) == NULL) return NULL;
+  if (Gindex_add(table, hash, nstring) != OK) return NULL;
+  return string[nstring++];
+}
+
+/*************************************************************/
+/*                                                           */
+/*                          Gintern                          */
+/*                                                           */
+/*************************************************************/
+char *Gintern(char *s)
+{
+  /* The shared copy of 's', entered into the table if new.
+
+	 Returns: the interned string, if success.  Do not modify or free.
+	          NULL, if 's' is NULL or out of memory.
+  */
+  char *p;
+
+  if (s == NULL) return NULL;
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_lock(&intern_lock);
+#endif
+  p = intern(s);
+#ifdef HAVE_LIBPTHREAD
+  pthread_mutex_unlock(&intern_lock);
+#endif
+  if (p == NULL) perror("Gintern");
+  return p;
+}
@@ -0,0 +1,383 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************
+
+	Conversion between GSL gauges and the toolkit's 2A-56/2A-57
+	structures (L2A_56_RAINGAUGE, L2A_57_DISDROMETER).
+
+	An L2A structure has room for 1440 observations; a 2A-57 one is
+	mostly its 1440 x 20 int16 'nConcentration' block.  A staging
+	buffer (new_l2a_stage) is one such structure kept for a whole
+	granule: filling it for the next gauge rewrites the slots that
+	gauge uses and clears only the ones the previous gauge used
+	beyond that, instead of clearing all 1440.
+
+	Drop concentrations are converted a whole gauge at a time when
+	its values are laid out as Gnew_gauge does it, with SSE2 when the
+	compiler has it.  Going to int16 truncates toward zero, as a C
+	cast does, and saturates: values beyond the int16 range become
+	-32768 or 32767 and NaNs become 0.
+
+*******************************************************************/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "gsl.h"
+#include "gsl_tk.h"
+
+#define L2A_NOBS 1440  /* Observation slots of an L2A structure. */
+
+/*************************************************************/
+/*                                                           */
+/*                   Conversion kernels                      */
+/*                                                           */
+/*************************************************************/
+static int16 float_to_int16(float x)
+{
+  if (x != x) return 0;                /* NaN */
+  if (x >= 32767.0) return 32767;
+  if (x <= -32768.0) return -32768;
+  return (int16)x;
+}
+
+static void floats_to_int16(const float *x, int16 *y, int n)
+{
+  int j = 0;
+#ifdef __SSE2__
+  __m128 lo, hi, a, b;
+
+  lo = _mm_set1_ps(-32768.0);
+  hi = _mm_set1_ps(32767.0);
+  for (; j+8 <= n; j += 8) {
+	a = _mm_loadu_ps(x+j);
+	b = _mm_loadu_ps(x+j+4);
+	/* Clamp first so the conversion cannot overflow; NaNs to 0. */
+	a = _mm_and_ps(_mm_min_ps(_mm_max_ps(a, lo), hi), _mm_cmpord_ps(a, a));
+	b = _mm_and_ps(_mm_min_ps(_mm_max_ps(b, lo), hi), _mm_cmpord_ps(b, b));
+	_mm_storeu_si128((__m128i *)(y+j),
+					 _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)));
+  }
+#endif
+  for (; j<n; j++)
+	y[j] = float_to_int16(x[j]);
+}
+
+static void int16_to_floats(const int16 *x, float *y, int n)
+{
+  int j = 0;
+#ifdef __SSE2__
+  __m128i v;
+
+  for (; j+8 <= n; j += 8) {
+	v = _mm_loadu_si128((const __m128i *)(x+j));
+	/* Sign extend: each int16 into the top half of an int32, then down. */
+	_mm_storeu_ps(y+j,
+				  _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)));
+	_mm_storeu_ps(y+j+4,
+				  _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)));
+  }
+#endif
+  for (; j<n; j++)
+	y[j] = x[j];
+}
+
+static Gauge_record *granule_record(Gauge *g, Granule_gauge *gg, int j)
+{
+  return &g->record[gg->order ? gg->order[gg->first+j] : gg->first+j];
+}
+
+static int contiguous_range(Gauge *g, Granule_gauge *gg)
+{
+  /* Nonzero when the picked records' values are one block of floats. */
+  float *v;
+  int j;
+
+  if (gg->order != NULL || gg->nobs == 0) return 0;
+  v = g->record[gg->first].value;
+  for (j=1; j<gg->nobs; j++)
+	if (g->record[gg->first+j].value != v + j*g->h.nbin) return 0;
+  return 1;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                         l2a_fill                          */
+/*                                                           */
+/*************************************************************/
+int l2a_fill(void *l2a, int productType, Gauge *gauge, Granule_gauge *gg,
+			 int networkID, int nclear)
+{
+  /* Moves the records picked by 'gg' into the 2A-56 or 2A-57 structure
+	 'l2a', as slots 0..gg->nobs-1, and zeroes slots gg->nobs..nclear-1.
+	 The other slots must already be zero.  Checks that all the
+	 observations are from the same 24 hr period.
+
+	 Returns: OK, if success.
+	          ABORT, if fail.
+  */
+  L2A_56_RAINGAUGE   *l2a56;
+  L2A_57_DISDROMETER *l2a57;
+  Gauge_record *r;
+  int j, k, n, nbin, rowlen, this_jday;
+
+  if (gauge == NULL) return(ABORT);
+  n = gg->nobs;
+  /* The number of observations cannot exceed 1440 (24hr*60min/hr). */
+  if (n > L2A_NOBS) {
+	fprintf(stderr, "gauge->h.nobs = %d ... exceeds HDF limit of 1440.\n", n);
+	return(ABORT);
+  }
+  if (nclear > L2A_NOBS) nclear = L2A_NOBS;
+
+  this_jday = (n > 0) ? granule_record(gauge, gg, 0)->time.jday : 0;
+  for (j=1; j<n; j++)
+	if (granule_record(gauge, gg, j)->time.jday != this_jday) {
+	  fprintf(stderr, "%s observations not all from same day.\n",
+			  (productType == TK_L2A_57) ? "Disdrometer" : "Raingauge");
+	  return(ABORT);
+	}
+
+  if (productType == TK_L2A_56) {
+	l2a56 = (L2A_56_RAINGAUGE *)l2a;
+	memset(&l2a56->gaugeDesc, 0, sizeof(l2a56->gaugeDesc));
+	l2a56->gaugeDesc.networkID = networkID;
+	strncpy(l2a56->gaugeDesc.gaugeType, gauge->h.type, 21);
+	strncpy(l2a56->gaugeDesc.gaugeName, gauge->h.name, 21);
+	l2a56->gaugeDesc.gaugeNumber  = gauge->h.number;
+	l2a56->gaugeDesc.gaugeLat     = gauge->h.lat;
+	l2a56->gaugeDesc.gaugeLong    = gauge->h.lon;
+	l2a56->gaugeDesc.range        = gauge->h.range;
+	l2a56->gaugeDesc.azimuth      = gauge->h.azimuth;
+	l2a56->gaugeDesc.resolution   = gauge->h.resolution;
+	l2a56->gaugeDesc.elevation    = gauge->h.elevation;
+	for (j=0; j<n; j++) {
+	  r = granule_record(gauge, gg, j);
+	  l2a56->hour[j]         = r->time.hour;
+	  l2a56->minute[j]       = r->time.minute;
+	  l2a56->meanRainRate[j] = r->value[0];
+	}
+	for (; j<nclear; j++) {
+	  l2a56->hour[j]         = 0;
+	  l2a56->minute[j]       = 0;
+	  l2a56->meanRainRate[j] = 0;
+	}
+	return(OK);
+  }
+
+  /* Disdrometer */
+  l2a57 = (L2A_57_DISDROMETER *)l2a;
+  memset(&l2a57->disdroDesc, 0, sizeof(l2a57->disdroDesc));
+  l2a57->disdroDesc.networkID = networkID;
+  strncpy(l2a57->disdroDesc.disdroName, gauge->h.name, 21);
+  l2a57->disdroDesc.disdroNumber  = gauge->h.number;
+  l2a57->disdroDesc.disdroLat     = gauge->h.lat;
+  l2a57->disdroDesc.disdroLong    = gauge->h.lon;
+  l2a57->disdroDesc.range        = gauge->h.range;
+  l2a57->disdroDesc.azimuth      = gauge->h.azimuth;
+  l2a57->disdroDesc.resolution   = gauge->h.resolution;
+  l2a57->disdroDesc.elevation    = gauge->h.elevation;
+  for (j=0; j<n; j++) {
+	r = granule_record(gauge, gg, j);
+	l2a57->hour[j]   = r->time.hour;
+	l2a57->minute[j] = r->time.minute;
+  }
+  rowlen = sizeof(l2a57->nConcentration[0])/sizeof(int16);
+  nbin = (gauge->h.nbin < rowlen) ? gauge->h.nbin : rowlen;
+  if (nbin == rowlen && gauge->h.nbin == rowlen && contiguous_range(gauge, gg))
+	floats_to_int16(gauge->record[gg->first].value,
+					&l2a57->nConcentration[0][0], n*rowlen);
+  else
+	for (j=0; j<n; j++) {
+	  floats_to_int16(granule_record(gauge, gg, j)->value,
+					  l2a57->nConcentration[j], nbin);
+	  for (k=nbin; k<rowlen; k++) l2a57->nConcentration[j][k] = 0;
+	}
+  if (nclear > n) {
+	for (j=n; j<nclear; j++) {
+	  l2a57->hour[j]   = 0;
+	  l2a57->minute[j] = 0;
+	}
+	memset(l2a57->nConcentration[n], 0,
+		   (nclear - n)*sizeof(l2a57->nConcentration[0]));
+  }
+  return(OK);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                       l2a_to_gauge                        */
+/*                                                           */
+/*************************************************************/
+Gauge *l2a_to_gauge(void *l2a, int productType, Gtime_key day)
+{
+  /* A new gauge with the observations of 2A-56 or 2A-57 structure
+	 'l2a': slots up to the last one with a nonzero time.  The slots
+	 hold only hour and minute; 'day' is 00:00 of the granule's date
+	 (see Ghdf_complex).  g->h.network is left for the caller.
+
+	 Returns: the gauge, if success.
+	          NULL, if out of memory.
+  */
+  L2A_56_RAINGAUGE   *l2a56 = (L2A_56_RAINGAUGE *)l2a;
+  L2A_57_DISDROMETER *l2a57 = (L2A_57_DISDROMETER *)l2a;
+  Gauge *g;
+  int j, nobs, nbin;
+
+  if (productType == TK_L2A_56) {
+	for (nobs=L2A_NOBS; nobs>0; nobs--)
+	  if (l2a56->hour[nobs-1] || l2a56->minute[nobs-1]) break;
+	/* Gauge contains 'nobs' observations, each consisting of 1 bin. */
+	g = Gnew_gauge(nobs > 0 ? nobs : 1, 1);
+	if (g == NULL || g->record == NULL || g->record->value == NULL) return(NULL);
+	g->h.number = l2a56->gaugeDesc.gaugeNumber;
+	g->h.name = (char *) strdup(l2a56->gaugeDesc.gaugeName);
+	g->h.type = Gintern(l2a56->gaugeDesc.gaugeType);
+	g->h.resolution = l2a56->gaugeDesc.resolution;
+	g->h.lat = l2a56->gaugeDesc.gaugeLat;
+	g->h.lon = l2a56->gaugeDesc.gaugeLong;
+	g->h.azimuth = l2a56->gaugeDesc.azimuth;
+	g->h.range = l2a56->gaugeDesc.range;
+	g->h.elevation = l2a56->gaugeDesc.elevation;
+	for (j=0; j<nobs; j++) {
+	  Gkey_to_time(day + l2a56->hour[j]*3600 + l2a56->minute[j]*60,
+				   &g->record[j].time);
+	  g->record[j].value[0] = l2a56->meanRainRate[j];
+	}
+  } else {
+	for (nobs=L2A_NOBS; nobs>0; nobs--)
+	  if (l2a57->hour[nobs-1] || l2a57->minute[nobs-1]) break;
+	/* Gauge contains 'nobs' observations, each consisting of 20 bins. */
+	nbin = sizeof(l2a57->nConcentration[0])/sizeof(int16);
+	g = Gnew_gauge(nobs > 0 ? nobs : 1, nbin);
+	if (g == NULL || g->record == NULL || g->record->value == NULL) return(NULL);
+	g->h.number = l2a57->disdroDesc.disdroNumber;
+	g->h.name = (char *) strdup(l2a57->disdroDesc.disdroName);
+	g->h.type = Gintern("DSD");
+	g->h.resolution = l2a57->disdroDesc.resolution;
+	g->h.lat = l2a57->disdroDesc.disdroLat;
+	g->h.lon = l2a57->disdroDesc.disdroLong;
+	g->h.azimuth = l2a57->disdroDesc.azimuth;
+	g->h.range = l2a57->disdroDesc.range;
+	g->h.elevation = l2a57->disdroDesc.elevation;
+	for (j=0; j<nobs; j++)
+	  Gkey_to_time(day + l2a57->hour[j]*3600 + l2a57->minute[j]*60,
+				   &g->record[j].time);
+	/* Gnew_gauge lays the values out just like nConcentration. */
+	int16_to_floats(&l2a57->nConcentration[0][0], g->record->value, nobs*nbin);
+  }
+  g->h.nobs = nobs;
+  return(g);
+}
+
+/*************************************************************/
+/*                                                           */
+/*               new_l2a_stage / free_l2a_stage              */
+/*                                                           */
+/*************************************************************/
+L2A_stage *new_l2a_stage(int productType)
+{
+  /* A zeroed, 16-byte aligned L2A_56_RAINGAUGE (productType TK_L2A_56)
+	 or L2A_57_DISDROMETER (TK_L2A_57), to be filled by stage_gauge.
+
+	 Returns: stage, if success.  Free with free_l2a_stage.
+	          NULL, if out of memory.
+  */
+  L2A_stage *st;
+  size_t size;
+
+  size = (productType == TK_L2A_57) ? sizeof(L2A_57_DISDROMETER)
+	                                : sizeof(L2A_56_RAINGAUGE);
+  st = (L2A_stage *)calloc(1, sizeof(L2A_stage));
+  if (st == NULL || (st->mem = (char *)calloc(1, size + 15)) == NULL) {
+	perror("new_l2a_stage");
+	if (st) free(st);
+	return NULL;
+  }
+  st->productType = productType;
+  st->l2a = (void *)(st->mem + ((16 - ((size_t)st->mem & 15)) & 15));
+  return st;
+}
+
+void free_l2a_stage(L2A_stage *st)
+{
+  if (st == NULL) return;
+  free(st->mem);
+  free(st);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                        stage_gauge                        */
+/*                                                           */
+/*************************************************************/
+int stage_gauge(L2A_stage *st, Gauge *gauge, Granule_gauge *gg, int networkID)
+{
+  /* Fills st->l2a with the records picked by 'gg' (see l2a_fill).
+	 Returns: OK, if success.
+	          ABORT, if fail.
+  */
+  int status;
+
+  /* l2a_fill changes nothing when it fails. */
+  status = l2a_fill(st->l2a, st->productType, gauge, gg, networkID, st->nused);
+  if (status == OK) st->nused = gg->nobs;
+  return status;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                        clear_stage                        */
+/*                                                           */
+/*************************************************************/
+void clear_stage(L2A_stage *st)
+{
+  /* Zeroes the descriptor and slots 0..st->nused-1 of st->l2a, so the
+	 whole structure is zero again, for a reader that sets only some of
+	 the fields.  Leaves st->nused at the maximum: the caller lowers it
+	 once it knows how many slots the next read filled.
+  */
+  L2A_56_RAINGAUGE   *l2a56 = (L2A_56_RAINGAUGE *)st->l2a;
+  L2A_57_DISDROMETER *l2a57 = (L2A_57_DISDROMETER *)st->l2a;
+  int n;
+
+  n = (st->nused < L2A_NOBS) ? st->nused : L2A_NOBS;
+  if (st->productType == TK_L2A_56) {
+	memset(&l2a56->gaugeDesc, 0, sizeof(l2a56->gaugeDesc));
+	memset(l2a56->hour, 0, n*sizeof(l2a56->hour[0]));
+	memset(l2a56->minute, 0, n*sizeof(l2a56->minute[0]));
+	memset(l2a56->meanRainRate, 0, n*sizeof(l2a56->meanRainRate[0]));
+  } else {
+	memset(&l2a57->disdroDesc, 0, sizeof(l2a57->disdroDesc));
+	memset(l2a57->hour, 0, n*sizeof(l2a57->hour[0]));
+	memset(l2a57->minute, 0, n*sizeof(l2a57->minute[0]));
+	memset(l2a57->nConcentration, 0, n*sizeof(l2a57->nConcentration[0]));
+  }
+  st->nused = L2A_NOBS;
+}
@@ -0,0 +1,492 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************
+
+	Which gauges are in radar bin (ray, gate), and which bin is
+	gauge i in.
+
+	A Gpolar_lut places a network's gauges on a polar grid around the
+	radar: 'nray' rays 'az_step' degrees apart, ray 0 centered on
+	north, and gates 'gate_km' deep out to 'max_range' km.  Bin b is
+	ray b/ngate, gate b%ngate.  Gauges beyond max_range are in no bin.
+
+	Both questions take constant time: gauge i's bin is an array
+	entry, and the few bins that hold gauges are found through a
+	Gindex keyed by bin number.  Building the table is two passes over
+	the gauges, each a hash lookup per gauge; no per-bin work is done.
+
+	Gpolar_lut_for_sitelist builds the table for a sitelist file and
+	keeps it in a cache directory, in a file named after a hash of the
+	sitelist's contents, the radar location and the grid.  A changed
+	sitelist or grid gets a new file; stale ones are never read.  The
+	file holds the sitelist text, radar and grid it was built from and
+	is used only if they match, so a hash collision costs a rebuild,
+	never another sitelist's table.
+
+*******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "gsl.h"
+
+#define LUT_MAGIC "GSLLUT2\n"
+
+/*************************************************************/
+/*                                                           */
+/*                  Building the bin tables                  */
+/*                                                           */
+/*************************************************************/
+static int polar_bin(Gpolar_lut *lut, float range, float azimuth)
+{
+  /* Bin of a point, or -1. */
+  int ray, gate;
+
+  if (!(range >= 0) || range >= lut->max_range) return -1;
+  if (!(azimuth >= -360 && azimuth <= 720)) return -1;
+  gate = (int)(range/lut->gate_km);
+  if (gate >= lut->ngate) return -1;
+  ray = (int)(azimuth/lut->az_step + 0.5 + lut->nray) % lut->nray;
+  return ray*lut->ngate + gate;
+}
+
+static Gpolar_lut *new_polar_lut(int ngauge, float az_step, float gate_km,
+								 float max_range)
+{
+  Gpolar_lut *lut;
+
+  if (ngauge < 0 || !(az_step > 0) || az_step > 360 ||
+	  !(gate_km > 0) || !(max_range > 0)) {
+	fprintf(stderr, "Gnew_polar_lut: bad grid: %g deg, %g km, %g km.\n",
+			az_step, gate_km, max_range);
+	return NULL;
+  }
+  lut = (Gpolar_lut *)calloc(1, sizeof(Gpolar_lut));
+  if (lut == NULL) {
+	perror("Gnew_polar_lut");
+	return NULL;
+  }
+  lut->nray = (int)(360.0/az_step + 0.5);
+  if (lut->nray < 1) lut->nray = 1;
+  lut->az_step   = 360.0/lut->nray;
+  lut->gate_km   = gate_km;
+  lut->max_range = max_range;
+  lut->ngate = (int)(max_range/gate_km);
+  if (lut->ngate*gate_km < max_range) lut->ngate++;
+  lut->ngauge = ngauge;
+  lut->gauge_bin = (int *)malloc((ngauge+1)*sizeof(int));
+  lut->gauge     = (int *)malloc((ngauge+1)*sizeof(int));
+  lut->bin       = (int *)malloc((ngauge+1)*sizeof(int));
+  lut->start     = (int *)malloc((ngauge+2)*sizeof(int));
+  if (lut->gauge_bin == NULL || lut->gauge == NULL ||
+	  lut->bin == NULL || lut->start == NULL) {
+	perror("Gnew_polar_lut");
+	Gfree_polar_lut(lut);
+	return NULL;
+  }
+  return lut;
+}
+
+typedef struct {
+  Gpolar_lut *lut;
+  int         bin;
+} Bin_key;
+
+static int same_bin(int k, void *arg)
+{
+  Bin_key *key = (Bin_key *)arg;
+  return key->lut->bin[k] == key->bin;
+}
+
+static int index_bins(Gpolar_lut *lut)
+{
+  /* From lut->gauge_bin, fills the bin -> gauge tables.  A counting
+	 sort over the occupied bins: bins are numbered in the order their
+	 first gauge appears, and each bin lists its gauges in gauge order.
+  */
+  Bin_key key;
+  int i, n, k, b, *next;
+
+  next = (int *)malloc((lut->ngauge+1)*sizeof(int));
+  lut->by_bin = Gnew_index(lut->ngauge);
+  if (next == NULL || lut->by_bin == NULL) {
+	if (next == NULL) perror("Gnew_polar_lut");
+	if (next) free(next);
+	return ABORT;
+  }
+
+  /* Number the occupied bins and count their gauges. */
+  key.lut = lut;
+  lut->nbin = 0;
+  for (i=n=0; i<lut->ngauge; i++) {
+	b = lut->gauge_bin[i];
+	if (b < 0) continue;
+	key.bin = b;
+	k = Gindex_find(lut->by_bin, Ghash_int(b), same_bin, &key);
+	if (k < 0) {
+	  k = lut->nbin++;
+	  lut->bin[k] = b;
+	  lut->start[k] = 0;
+	  if (Gindex_add(lut->by_bin, Ghash_int(b), k) != OK) {
+		free(next);
+		return ABORT;
+	  }
+	}
+	lut->start[k]++;
+	n++;
+  }
+
+  /* Counts to offsets, then drop each gauge into its bin. */
+  for (k=0, i=0; k<lut->nbin; k++) {
+	next[k] = i;
+	i += lut->start[k];
+	lut->start[k] = next[k];
+  }
+  lut->start[lut->nbin] = n;
+  for (i=0; i<lut->ngauge; i++) {
+	b = lut->gauge_bin[i];
+	if (b < 0) continue;
+	key.bin = b;
+	k = Gindex_find(lut->by_bin, Ghash_int(b), same_bin, &key);
+	lut->gauge[next[k]++] = i;
+  }
+  free(next);
+  return OK;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                Gnew_polar_lut / Gfree_polar_lut           */
+/*                                                           */
+/*************************************************************/
+Gpolar_lut *Gnew_polar_lut(int ngauge, float *range, float *azimuth,
+						   float az_step, float gate_km, float max_range)
+{
+  /* Gauge i is at range[i] km, azimuth[i] degrees from the radar.
+
+	 Returns: table, if success.  Free with Gfree_polar_lut.
+	          NULL, if the grid is bad or out of memory.
+  */
+  Gpolar_lut *lut;
+  int i;
+
+  if (ngauge > 0 && (range == NULL || azimuth == NULL)) return NULL;
+  lut = new_polar_lut(ngauge, az_step, gate_km, max_range);
+  if (lut == NULL) return NULL;
+  for (i=0; i<ngauge; i++)
+	lut->gauge_bin[i] = polar_bin(lut, range[i], azimuth[i]);
+  if (index_bins(lut) != OK) {
+	Gfree_polar_lut(lut);
+	return NULL;
+  }
+  return lut;
+}
+
+void Gfree_polar_lut(Gpolar_lut *lut)
+{
+  if (lut == NULL) return;
+  if (lut->gauge_bin) free(lut->gauge_bin);
+  if (lut->gauge) free(lut->gauge);
+  if (lut->bin) free(lut->bin);
+  if (lut->start) free(lut->start);
+  Gfree_index(lut->by_bin);
+  free(lut);
+}
+
+/*************************************************************/
+/*                                                           */
+/*         Gpolar_lut_of_list / Gpolar_lut_of_network        */
+/*                                                           */
+/*************************************************************/
+Gpolar_lut *Gpolar_lut_of_list(Gauge_list *glist, float az_step,
+							   float gate_km, float max_range)
+{
+  /* Gauge i is glist->g[i]. */
+  Gpolar_lut *lut;
+  int i;
+
+  if (glist == NULL) return NULL;
+  lut = new_polar_lut(glist->ngauges, az_step, gate_km, max_range);
+  if (lut == NULL) return NULL;
+  for (i=0; i<glist->ngauges; i++)
+	lut->gauge_bin[i] = polar_bin(lut, glist->g[i].range,
+								  glist->g[i].azimuth);
+  if (index_bins(lut) != OK) {
+	Gfree_polar_lut(lut);
+	return NULL;
+  }
+  return lut;
+}
+
+Gpolar_lut *Gpolar_lut_of_network(Gauge_network *gnet, float az_step,
+								  float gate_km, float max_range)
+{
+  /* Gauge i is gnet->gauge[i], placed by its h.range and h.azimuth.
+	 A gauge not read yet (Gopen_hdf_complex) is in no bin. */
+  Gpolar_lut *lut;
+  int i;
+
+  if (gnet == NULL) return NULL;
+  lut = new_polar_lut(gnet->h.ngauge, az_step, gate_km, max_range);
+  if (lut == NULL) return NULL;
+  for (i=0; i<gnet->h.ngauge; i++)
+	lut->gauge_bin[i] = (gnet->gauge[i] == NULL) ? -1 :
+	  polar_bin(lut, gnet->gauge[i]->h.range, gnet->gauge[i]->h.azimuth);
+  if (index_bins(lut) != OK) {
+	Gfree_polar_lut(lut);
+	return NULL;
+  }
+  return lut;
+}
+
+/*************************************************************/
+/*                                                           */
+/*              Gpolar_lut_gauges / Gpolar_lut_bin           */
+/*                                                           */
+/*************************************************************/
+int Gpolar_lut_gauges(Gpolar_lut *lut, int ray, int gate, int **gauge)
+{
+  /* *gauge is set to the gauges in bin (ray, gate), lowest number
+	 first.  The list belongs to the table.
+
+	 Returns: the number of gauges in the bin, 0 for an empty bin or
+	          one outside the grid.
+  */
+  Bin_key key;
+  int k;
+
+  if (gauge) *gauge = NULL;
+  if (lut == NULL || ray < 0 || ray >= lut->nray ||
+	  gate < 0 || gate >= lut->ngate) return 0;
+  key.lut = lut;
+  key.bin = ray*lut->ngate + gate;
+  k = Gindex_find(lut->by_bin, Ghash_int(key.bin), same_bin, &key);
+  if (k < 0) return 0;
+  if (gauge) *gauge = lut->gauge + lut->start[k];
+  return lut->start[k+1] - lut->start[k];
+}
+
+int Gpolar_lut_bin(Gpolar_lut *lut, int i, int *ray, int *gate)
+{
+  /* The bin gauge i is in: *ray and *gate, either may be NULL.
+
+	 Returns: the bin number, ray*ngate + gate.
+	          -1, if the gauge is beyond max_range (or i is bad).
+  */
+  int b;
+
+  if (lut == NULL || i < 0 || i >= lut->ngauge) return -1;
+  b = lut->gauge_bin[i];
+  if (b >= 0) {
+	if (ray)  *ray  = b / lut->ngate;
+	if (gate) *gate = b % lut->ngate;
+  }
+  return b;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                 Gpolar_lut_for_sitelist                   */
+/*                                                           */
+/*************************************************************/
+static unsigned int hash_float(unsigned int h, float x)
+{
+  unsigned int bits;
+
+  memcpy(&bits, &x, sizeof(bits));
+  return Ghash_int(h ^ bits);
+}
+
+static char *read_text_file(char *file, long *len)
+{
+  /* The whole file, NUL terminated, and its length; or NULL. */
+  FILE *fp;
+  char *buf;
+  long n;
+
+  if ((fp = fopen(file, "r")) == NULL) return NULL;
+  buf = NULL;
+  if (fseek(fp, 0, SEEK_END) == 0 && (n = ftell(fp)) >= 0 &&
+	  fseek(fp, 0, SEEK_SET) == 0 &&
+	  (buf = (char *)malloc(n+1)) != NULL) {
+	n = fread(buf, 1, n, fp);
+	buf[n] = '\0';
+	*len = n;
+  }
+  fclose(fp);
+  return buf;
+}
+
+/* What a cached table was built from.  The key only names the file;
+ * a table is used only if all of this matches.
+ */
+typedef struct {
+  unsigned int key;
+  float grid[5];   /* az_step (as asked for), gate_km, max_range,
+					* radar lat, radar lon. */
+  long  len;       /* The sitelist text. */
+  char *text;
+} Lut_source;
+
+static Gpolar_lut *read_lut_cache(char *file, Lut_source *src)
+{
+  /* NULL if the file is missing or not built from 'src'. */
+  Gpolar_lut *lut;
+  FILE *fp;
+  char magic[8], *text;
+  unsigned int k;
+  float grid[5];
+  long len;
+  int i, n, ok;
+
+  if ((fp = fopen(file, "rb")) == NULL) return NULL;
+  lut = NULL;
+  text = NULL;
+  ok = fread(magic, sizeof(magic), 1, fp) == 1 &&
+	   memcmp(magic, LUT_MAGIC, sizeof(magic)) == 0 &&
+	   fread(&k, sizeof(k), 1, fp) == 1 && k == src->key &&
+	   fread(grid, sizeof(grid), 1, fp) == 1 &&
+	   memcmp(grid, src->grid, sizeof(grid)) == 0 &&
+	   fread(&len, sizeof(len), 1, fp) == 1 && len == src->len &&
+	   (text = (char *)malloc(len+1)) != NULL &&
+	   fread(text, 1, len, fp) == (size_t)len &&
+	   memcmp(text, src->text, len) == 0 &&
+	   fread(&n, sizeof(n), 1, fp) == 1 && n >= 0 && n <= 1000000 &&
+	   (lut = new_polar_lut(n, src->grid[0], src->grid[1],
+							src->grid[2])) != NULL &&
+	   fread(lut->gauge_bin, sizeof(int), n, fp) == (size_t)n;
+  fclose(fp);
+  if (text) free(text);
+  for (i=0; ok && i<n; i++)
+	if (lut->gauge_bin[i] < -1 ||
+		lut->gauge_bin[i] >= lut->nray*lut->ngate) ok = 0;
+  if (ok && index_bins(lut) == OK) {
+	lut->key = src->key;
+	return lut;
+  }
+  fprintf(stderr, "Gpolar_lut_for_sitelist: ignoring cache %s; "
+		  "it is bad or for another sitelist.\n", file);
+  Gfree_polar_lut(lut);
+  return NULL;
+}
+
+static void write_lut_cache(char *file, Gpolar_lut *lut, Lut_source *src)
+{
+  /* Written under a unique temporary name and renamed, so readers
+	 never see a partial file and concurrent writers (threads or
+	 processes) never share one. */
+  FILE *fp;
+  char tmp[420];
+  int fd, ok;
+
+  snprintf(tmp, sizeof(tmp), "%s.XXXXXX", file);
+  if ((fd = mkstemp(tmp)) < 0) {
+	perror(tmp);
+	return;
+  }
+  if ((fp = fdopen(fd, "wb")) == NULL) {
+	perror(tmp);
+	close(fd);
+	unlink(tmp);
+	return;
+  }
+  ok = fwrite(LUT_MAGIC, 8, 1, fp) == 1 &&
+	   fwrite(&src->key, sizeof(src->key), 1, fp) == 1 &&
+	   fwrite(src->grid, sizeof(src->grid), 1, fp) == 1 &&
+	   fwrite(&src->len, sizeof(src->len), 1, fp) == 1 &&
+	   fwrite(src->text, 1, src->len, fp) == (size_t)src->len &&
+	   fwrite(&lut->ngauge, sizeof(int), 1, fp) == 1 &&
+	   fwrite(lut->gauge_bin, sizeof(int), lut->ngauge, fp) == (size_t)lut->ngauge;
+  if (fclose(fp) != 0) ok = 0;
+  if (!ok || rename(tmp, file) != 0) {
+	perror(file);
+	unlink(tmp);
+  }
+}
+
+Gpolar_lut *Gpolar_lut_for_sitelist(char *top_dir, char *gnet,
+									float radarLat, float radarLon,
+									float az_step, float gate_km,
+									float max_range, char *cache_dir)
+{
+  /* The table for the gauges of <top_dir>/sitelist/<gnet>_loc.dat,
+	 gauge i being glist->g[i] of get_gauge_sites_info(top_dir, gnet,
+	 radarLat, radarLon).  With a 'cache_dir', the table is read from
+	 there if it was built before for the same sitelist contents,
+	 radar and grid; otherwise it is built and saved there.  A
+	 'cache_dir' of NULL builds the table every time.
+
+	 Returns: table, if success.  Free with Gfree_polar_lut.
+	          NULL, otherwise.
+  */
+  Gpolar_lut *lut;
+  Gauge_list *glist;
+  Lut_source src;
+  char sitefile[520], cachefile[400];
+  unsigned int key;
+  int i;
+
+  if (top_dir == NULL || gnet == NULL) return NULL;
+  if (strlen(top_dir) + strlen(gnet) > 250 ||
+	  (cache_dir && strlen(cache_dir) + strlen(gnet) > 350)) {
+	fprintf(stderr, "Gpolar_lut_for_sitelist: path too long.\n");
+	return NULL;
+  }
+  snprintf(sitefile, sizeof(sitefile), "%s/sitelist/%s_loc.dat",
+		   top_dir, gnet);
+  memset(&src, 0, sizeof(src));
+  if ((src.text = read_text_file(sitefile, &src.len)) == NULL) {
+	fprintf(stderr, "Cannot open sitelist %s\n", sitefile);
+	return NULL;
+  }
+  src.grid[0] = az_step;
+  src.grid[1] = gate_km;
+  src.grid[2] = max_range;
+  src.grid[3] = radarLat;
+  src.grid[4] = radarLon;
+  key = Ghash_string(src.text);
+  for (i=0; i<5; i++)
+	key = hash_float(key, src.grid[i]);
+  src.key = key;
+
+  lut = NULL;
+  if (cache_dir) {
+	snprintf(cachefile, sizeof(cachefile), "%s/%s.%08x.lut",
+			 cache_dir, gnet, key);
+	lut = read_lut_cache(cachefile, &src);
+  }
+  if (lut == NULL) {
+	glist = get_gauge_sites_info(top_dir, gnet, radarLat, radarLon);
+	if (glist != NULL) {
+	  lut = Gpolar_lut_of_list(glist, az_step, gate_km, max_range);
+	  free_gauge_list(glist);
+	}
+	if (lut != NULL) {
+	  lut->key = key;
+	  if (cache_dir) write_lut_cache(cachefile, lut, &src);
+	}
+  }
+  free(src.text);
+  return lut;
+}
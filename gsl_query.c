@@ -0,0 +1,114 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************
+
+	Time window queries.
+
+	The records of a gauge in the window [t0, t1) -- time keys, so
+	whole seconds; pass t1+1 to include t1 -- are a contiguous run
+	of 'record' when the gauge is in time order, and are found by
+	binary search on time.key: O(log nobs), nothing copied.
+
+	The gauges must be sorted (Gsort_gauge_in_place, or read from a
+	file in time order).  This is not checked, as checking would cost
+	more than the query.  Keys left unset are filled in first (see
+	Gcheck_gauge_time_keys).
+
+*******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "gsl.h"
+
+static int first_at_or_after(Gauge_record *r, int n, Gtime_key t)
+{
+  /* Binary search: the first j with r[j].time.key >= t. */
+  int lo = 0, hi = n, mid;
+
+  while (lo < hi) {
+	mid = lo + (hi - lo)/2;
+	if (r[mid].time.key < t) lo = mid+1;
+	else hi = mid;
+  }
+  return lo;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                 Gquery_gauge_time_range                   */
+/*                                                           */
+/*************************************************************/
+int Gquery_gauge_time_range(Gauge *g, Gtime_key t0, Gtime_key t1,
+							int *first)
+{
+  /* The records of 'g' from time t0 up to, not including, t1 are
+	 g->record[*first .. *first + n-1].  *first is where the window
+	 would start even when it is empty.
+
+	 Returns: n, the number of records in the window.
+	          ABORT, if g is NULL.
+  */
+  int n, j0, j1;
+
+  if (g == NULL) return ABORT;
+  Gcheck_gauge_time_keys(g);
+  n = (g->record == NULL || g->h.nobs < 0) ? 0 : g->h.nobs;
+  j0 = first_at_or_after(g->record, n, t0);
+  j1 = j0;
+  if (t1 > t0)
+	j1 += first_at_or_after(g->record + j0, n - j0, t1);
+  if (first) *first = j0;
+  return j1 - j0;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                Gquery_network_time_range                  */
+/*                                                           */
+/*************************************************************/
+int Gquery_network_time_range(Gauge_network *gnet, Gtime_key t0,
+							  Gtime_key t1, Gtime_slice *slice)
+{
+  /* slice[i] is set to gauge i's records in [t0, t1), for
+	 i = 0..gnet->h.ngauge-1.  The slices point into the gauges.  A
+	 gauge not read yet (see Gopen_hdf_complex) gets an empty slice.
+
+	 Returns: the number of records in all the slices.
+	          ABORT, if gnet or slice is NULL.
+  */
+  int i, n, total;
+
+  if (gnet == NULL || slice == NULL) return ABORT;
+  total = 0;
+  for (i=0; i<gnet->h.ngauge; i++) {
+	slice[i].g = gnet->gauge[i];
+	slice[i].first = 0;   /* Left alone for a gauge not read yet. */
+	n = Gquery_gauge_time_range(gnet->gauge[i], t0, t1, &slice[i].first);
+	if (n < 0) n = 0;
+	slice[i].n = n;
+	slice[i].record = (n > 0) ? gnet->gauge[i]->record + slice[i].first
+	                          : NULL;
+	total += n;
+  }
+  return total;
+}
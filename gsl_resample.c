@@ -0,0 +1,230 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************
+
+	Resampling the rain rates of a network's gauges to one time grid.
+
+	Cell k of the grid is [start + k*step, start + (k+1)*step); step
+	is 60, 300, 900, 3600 ... seconds.  A record with time key t of a
+	gauge with a resolution of R minutes stands for the rate value[0]
+	(mm/hr) over [t, t + 60R), so a 15 minute record is spread over
+	the 1 minute cells it covers, and 1 minute records are gathered
+	into a 15 minute cell.  Negative rates (missing data flags) and
+	NaNs are no data.
+
+	Each cell gets, as asked for,
+
+	  GSL_RESAMPLE_MEAN   the mean rate, mm/hr
+	  GSL_RESAMPLE_ACCUM  the rain total, mm
+	  GSL_RESAMPLE_MAX    the largest rate, mm/hr
+
+	Where a cell is not fully covered by data:
+
+	  GSL_GAPS_ZERO     gaps are no rain, as in Gaccumulate_gauge.
+	  GSL_GAPS_MISSING  the cell is 'missing' unless at least
+	                    'min_cover' (0..1) of it has data; the gaps
+	                    of the cells that remain take the mean rate of
+	                    the rest of the cell.
+
+	Each gauge is one pass over its records, in any order, into
+	per-cell sums; gauges are done in parallel (Gparallel_for).  The
+	result is a dense matrix, one row per cell and one column per
+	gauge: out[k*ngauge + i].
+
+*******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gsl.h"
+
+typedef struct {
+  Gauge    **gauge;     /* gauge[0..ngauge-1], the matrix columns. */
+  int        ngauge;
+  Gtime_key  start;
+  int        step, nstep;
+  int        how, gaps;
+  float      min_cover, missing;
+  float     *out;
+  int       *status;    /* status[i]: OK, or ABORT if gauge i failed. */
+} Resample_job;
+
+static void resample_gauge(int i, void *arg)
+{
+  Resample_job *rj = (Resample_job *)arg;
+  Gauge *g = rj->gauge[i];
+  Gtime_key end, t0, t1, c0, c1;
+  double *cover, *sum, ov, v;
+  float *max, rate;
+  int j, k, k0, k1, res;
+
+  cover = (double *)calloc(2*rj->nstep, sizeof(double));
+  max   = (float *)calloc(rj->nstep, sizeof(float));
+  if (cover == NULL || max == NULL) {
+	perror("Gresample_network");
+	if (cover) free(cover);
+	if (max) free(max);
+	rj->status[i] = ABORT;
+	return;
+  }
+  sum = cover + rj->nstep;
+
+  /* Record overlaps, cell by cell. */
+  end = rj->start + (Gtime_key)rj->nstep*rj->step;
+  res = (g != NULL && g->h.resolution > 0) ? (int)(g->h.resolution*60 + 0.5)
+	                                       : 60;
+  if (res < 1) res = 1;
+  for (j=0; g != NULL && g->record != NULL && j<g->h.nobs; j++) {
+	if (g->record[j].value == NULL) continue;
+	rate = g->record[j].value[0];
+	if (!(rate >= 0)) continue;
+	t0 = g->record[j].time.key;
+	t1 = t0 + res;
+	if (t1 <= rj->start || t0 >= end) continue;
+	if (t0 < rj->start) t0 = rj->start;
+	if (t1 > end) t1 = end;
+	k0 = (int)((t0 - rj->start)/rj->step);
+	k1 = (int)((t1 - 1 - rj->start)/rj->step);
+	for (k=k0; k<=k1; k++) {
+	  c0 = rj->start + (Gtime_key)k*rj->step;
+	  c1 = c0 + rj->step;
+	  ov = (double)(((t1 < c1) ? t1 : c1) - ((t0 > c0) ? t0 : c0));
+	  cover[k] += ov;
+	  sum[k]   += rate*ov;
+	  if (rate > max[k]) max[k] = rate;
+	}
+  }
+
+  /* Cells.  Overlapping records can cover a cell more than once. */
+  for (k=0; k<rj->nstep; k++) {
+	if (rj->gaps == GSL_GAPS_MISSING) {
+	  if (cover[k] <= 0 || cover[k] < rj->min_cover*rj->step) {
+		rj->out[(long)k*rj->ngauge + i] = rj->missing;
+		continue;
+	  }
+	  v = sum[k]/cover[k];                             /* mm/hr */
+	} else
+	  v = (cover[k] > rj->step) ? sum[k]/cover[k] : sum[k]/rj->step;
+	switch (rj->how) {
+	case GSL_RESAMPLE_ACCUM: v = v*rj->step/3600.0; break;
+	case GSL_RESAMPLE_MAX:   v = max[k];            break;
+	default:                                        break;
+	}
+	rj->out[(long)k*rj->ngauge + i] = v;
+  }
+  free(cover);
+  free(max);
+  rj->status[i] = OK;
+}
+
+static int resample(Gauge **gauge, int ngauge, Gtime_key start, int step,
+					int nstep, int how, int gaps, float min_cover,
+					float missing, int nthread, float *out)
+{
+  Resample_job rj;
+  int i, nfail;
+
+  if (out == NULL || step <= 0 || nstep < 0 ||
+	  (how != GSL_RESAMPLE_MEAN && how != GSL_RESAMPLE_ACCUM &&
+	   how != GSL_RESAMPLE_MAX) ||
+	  (gaps != GSL_GAPS_ZERO && gaps != GSL_GAPS_MISSING)) {
+	fprintf(stderr, "Gresample_network: bad arguments.\n");
+	return ABORT;
+  }
+  if (ngauge <= 0 || nstep == 0) return OK;
+  for (i=0; i<ngauge; i++)
+	Gcheck_gauge_time_keys(gauge[i]);
+  rj.gauge  = gauge;
+  rj.ngauge = ngauge;
+  rj.start  = start;
+  rj.step   = step;
+  rj.nstep  = nstep;
+  rj.how    = how;
+  rj.gaps   = gaps;
+  rj.min_cover = min_cover;
+  rj.missing   = missing;
+  rj.out    = out;
+  rj.status = (int *)malloc(ngauge*sizeof(int));
+  if (rj.status == NULL) {
+	perror("Gresample_network");
+	return ABORT;
+  }
+  Gparallel_for(ngauge, nthread, resample_gauge, &rj);
+  for (i=nfail=0; i<ngauge; i++)
+	if (rj.status[i] != OK) nfail++;
+  free(rj.status);
+  return (nfail == 0) ? OK : ABORT;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                    Gresample_network                      */
+/*                                                           */
+/*************************************************************/
+int Gresample_network(Gauge_network *gnet, Gtime_key start, int step,
+					  int nstep, int how, int gaps, float min_cover,
+					  float missing, int nthread, float *out)
+{
+  /* Resamples the gauges of 'gnet' to 'nstep' cells of 'step' seconds
+	 from time key 'start', as described above.  Cell k of gauge i
+	 goes to out[k*ngauge + i]; 'out' holds nstep*ngauge floats.
+	 'nthread' is as for Gparallel_for.
+
+	 Returns: OK, if success.
+	          ABORT, if the arguments are bad or out of memory.
+  */
+  if (gnet == NULL) return ABORT;
+  return resample(gnet->gauge, gnet->h.ngauge, start, step, nstep, how,
+				  gaps, min_cover, missing, nthread, out);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                    Gresample_complex                      */
+/*                                                           */
+/*************************************************************/
+int Gresample_complex(Gauge_complex *gc, Gtime_key start, int step,
+					  int nstep, int how, int gaps, float min_cover,
+					  float missing, int nthread, float *out)
+{
+  /* As Gresample_network, for every gauge of 'gc': the columns are
+	 the gauges of network 0, then network 1, ... */
+  Gauge **gauge;
+  int i, j, n, status;
+
+  if (gc == NULL) return ABORT;
+  for (j=n=0; j<gc->h.nnet; j++)
+	n += gc->net[j]->h.ngauge;
+  gauge = (Gauge **)malloc((n+1)*sizeof(Gauge *));
+  if (gauge == NULL) {
+	perror("Gresample_complex");
+	return ABORT;
+  }
+  for (j=n=0; j<gc->h.nnet; j++)
+	for (i=0; i<gc->net[j]->h.ngauge; i++)
+	  gauge[n++] = gc->net[j]->gauge[i];
+  status = resample(gauge, n, start, step, nstep, how, gaps, min_cover,
+					missing, nthread, out);
+  free(gauge);
+  return status;
+}
@@ -0,0 +1,445 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************
+
+	Spatial index over gauge sites: which gauges lie within some
+	distance of a point, and which are the k nearest to it.
+
+	Sites are bucketed on a lat/lon grid whose cells are at least
+	'cell_km' across everywhere in the grid.  A query only looks at
+	the cells that can hold an answer and measures great circle
+	distances (earth radius 6378 km, as gauge_range_azimuth) to the
+	sites in them.
+
+	Points can also be given in the polar frame of a radar, as range
+	(km) and azimuth (degrees clockwise from north); see
+	Gset_site_index_radar.
+
+	Sites near the poles or on both sides of the 180th meridian are
+	not expected; the index still works there, only slower.
+
+*******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "gsl.h"
+
+#define EARTH_RADIUS 6378.0                       /* km */
+#define KM_PER_DEG   (EARTH_RADIUS*M_PI/180.0)
+#define DEG_TO_RAD   (M_PI/180.0)
+
+/*************************************************************/
+/*                                                           */
+/*                 Distances and directions                  */
+/*                                                           */
+/*************************************************************/
+static double site_distance(double lat1, double lon1, double lat2, double lon2)
+{
+  /* Great circle distance in km (haversine). */
+  double s1, s2, a;
+
+  s1 = sin(0.5*(lat2 - lat1)*DEG_TO_RAD);
+  s2 = sin(0.5*(lon2 - lon1)*DEG_TO_RAD);
+  a = s1*s1 + cos(lat1*DEG_TO_RAD)*cos(lat2*DEG_TO_RAD)*s2*s2;
+  if (a > 1.0) a = 1.0;
+  return 2.0*EARTH_RADIUS*asin(sqrt(a));
+}
+
+static void polar_to_latlon(double rlat, double rlon, double range,
+							double azimuth, float *lat, float *lon)
+{
+  /* The point 'range' km from (rlat, rlon) in direction 'azimuth'. */
+  double d, az, la1, la2, dlon;
+
+  d   = range/EARTH_RADIUS;
+  az  = azimuth*DEG_TO_RAD;
+  la1 = rlat*DEG_TO_RAD;
+  la2 = asin(sin(la1)*cos(d) + cos(la1)*sin(d)*cos(az));
+  dlon = atan2(sin(az)*sin(d)*cos(la1), cos(d) - sin(la1)*sin(la2));
+  *lat = la2/DEG_TO_RAD;
+  *lon = rlon + dlon/DEG_TO_RAD;
+}
+
+static double lon_km_per_deg(double abs_lat)
+{
+  /* Least km per degree of longitude at latitudes up to 'abs_lat'. */
+  if (abs_lat >= 89.0) abs_lat = 89.0;
+  return KM_PER_DEG*cos(abs_lat*DEG_TO_RAD);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                 Gnew_site_index / Gfree_site_index        */
+/*                                                           */
+/*************************************************************/
+Gsite_index *Gnew_site_index(int n, float *lat, float *lon, float cell_km)
+{
+  /* Indexes the 'n' sites (lat[i], lon[i]), in degrees.  Queries
+	 return site numbers i.  cell_km <= 0 picks 10 km, a good size
+	 when gauges are a few km apart.
+
+	 Returns: index, if success.  Free with Gfree_site_index.
+	          NULL, if out of memory.
+  */
+  Gsite_index *ix;
+  double lat_min, lat_max, lon_min, lon_max, abs_lat;
+  int i, c, ncell;
+
+  if (n < 0 || (n > 0 && (lat == NULL || lon == NULL))) return NULL;
+  if (cell_km <= 0) cell_km = 10.0;
+  ix = (Gsite_index *)calloc(1, sizeof(Gsite_index));
+  if (ix == NULL) {
+	perror("Gnew_site_index");
+	return NULL;
+  }
+  ix->nsite = n;
+  ix->lat = (float *)malloc((n+1)*sizeof(float));
+  ix->lon = (float *)malloc((n+1)*sizeof(float));
+  ix->site = (int *)malloc((n+1)*sizeof(int));
+  if (ix->lat == NULL || ix->lon == NULL || ix->site == NULL) goto oom;
+  if (n > 0) {
+	memcpy(ix->lat, lat, n*sizeof(float));
+	memcpy(ix->lon, lon, n*sizeof(float));
+  }
+
+  lat_min = lon_min = 0;
+  lat_max = lon_max = 0;
+  for (i=0; i<n; i++) {
+	if (i == 0 || lat[i] < lat_min) lat_min = lat[i];
+	if (i == 0 || lat[i] > lat_max) lat_max = lat[i];
+	if (i == 0 || lon[i] < lon_min) lon_min = lon[i];
+	if (i == 0 || lon[i] > lon_max) lon_max = lon[i];
+  }
+  abs_lat = (fabs(lat_min) > fabs(lat_max)) ? fabs(lat_min) : fabs(lat_max);
+  ix->lat0 = lat_min;
+  ix->lon0 = lon_min;
+  ix->abs_lat = abs_lat;
+  ix->dlat = cell_km/KM_PER_DEG;
+  ix->dlon = cell_km/lon_km_per_deg(abs_lat);
+  /* Far flung sites: coarser cells rather than a huge, empty grid. */
+  for (;;) {
+	ix->ny = (int)((lat_max - lat_min)/ix->dlat) + 1;
+	ix->nx = (int)((lon_max - lon_min)/ix->dlon) + 1;
+	if ((double)ix->nx*ix->ny <= 4.0*n + 16) break;
+	ix->dlat *= 2;
+	ix->dlon *= 2;
+  }
+  ix->cell_km = ix->dlat*KM_PER_DEG;
+
+  /* Counting sort of the sites by cell. */
+  ncell = ix->nx*ix->ny;
+  ix->start = (int *)calloc(ncell+1, sizeof(int));
+  if (ix->start == NULL) goto oom;
+  for (i=0; i<n; i++)
+	ix->start[Gsite_index_cell(ix, lat[i], lon[i]) + 1]++;
+  for (c=0; c<ncell; c++)
+	ix->start[c+1] += ix->start[c];
+  for (i=0; i<n; i++)
+	ix->site[ix->start[Gsite_index_cell(ix, lat[i], lon[i])]++] = i;
+  for (c=ncell; c>0; c--)
+	ix->start[c] = ix->start[c-1];
+  ix->start[0] = 0;
+  return ix;
+
+ oom:
+  perror("Gnew_site_index");
+  Gfree_site_index(ix);
+  return NULL;
+}
+
+void Gfree_site_index(Gsite_index *ix)
+{
+  if (ix == NULL) return;
+  if (ix->lat) free(ix->lat);
+  if (ix->lon) free(ix->lon);
+  if (ix->site) free(ix->site);
+  if (ix->start) free(ix->start);
+  if (ix->gauge) free(ix->gauge);
+  free(ix);
+}
+
+int Gsite_index_cell(Gsite_index *ix, float lat, float lon)
+{
+  /* The grid cell of (lat, lon), clamped to the grid. */
+  int x, y;
+
+  y = (int)floor((lat - ix->lat0)/ix->dlat);
+  x = (int)floor((lon - ix->lon0)/ix->dlon);
+  if (y < 0) y = 0;
+  if (y >= ix->ny) y = ix->ny-1;
+  if (x < 0) x = 0;
+  if (x >= ix->nx) x = ix->nx-1;
+  return y*ix->nx + x;
+}
+
+/*************************************************************/
+/*                                                           */
+/*          Gsite_index_of_list / Gsite_index_of_complex     */
+/*                                                           */
+/*************************************************************/
+Gsite_index *Gsite_index_of_list(Gauge_list *glist, float cell_km)
+{
+  /* Site i is glist->g[i]. */
+  Gsite_index *ix;
+  float *lat, *lon;
+  int i, n;
+
+  if (glist == NULL) return NULL;
+  n = glist->ngauges;
+  lat = (float *)malloc((n+1)*sizeof(float));
+  lon = (float *)malloc((n+1)*sizeof(float));
+  if (lat == NULL || lon == NULL) {
+	perror("Gsite_index_of_list");
+	if (lat) free(lat);
+	if (lon) free(lon);
+	return NULL;
+  }
+  for (i=0; i<n; i++) {
+	lat[i] = glist->g[i].lat;
+	lon[i] = glist->g[i].lon;
+  }
+  ix = Gnew_site_index(n, lat, lon, cell_km);
+  free(lat);
+  free(lon);
+  return ix;
+}
+
+Gsite_index *Gsite_index_of_complex(Gauge_complex *gc, float cell_km)
+{
+  /* Every gauge of 'gc', network 0 first; site i is ix->gauge[i]. */
+  Gsite_index *ix;
+  Gauge_network *net;
+  Gauge **gauge;
+  float *lat, *lon;
+  int i, j, n;
+
+  if (gc == NULL) return NULL;
+  /* Gauges not read yet (Gopen_hdf_complex) are left out. */
+  for (j=n=0; j<gc->h.nnet; j++)
+	for (i=0; i<gc->net[j]->h.ngauge; i++)
+	  if (gc->net[j]->gauge[i] != NULL) n++;
+  lat = (float *)malloc((n+1)*sizeof(float));
+  lon = (float *)malloc((n+1)*sizeof(float));
+  gauge = (Gauge **)malloc((n+1)*sizeof(Gauge *));
+  if (lat == NULL || lon == NULL || gauge == NULL) {
+	perror("Gsite_index_of_complex");
+	if (lat) free(lat);
+	if (lon) free(lon);
+	if (gauge) free(gauge);
+	return NULL;
+  }
+  for (j=n=0; j<gc->h.nnet; j++) {
+	net = gc->net[j];
+	for (i=0; i<net->h.ngauge; i++) {
+	  if (net->gauge[i] == NULL) continue;
+	  gauge[n] = net->gauge[i];
+	  lat[n] = net->gauge[i]->h.lat;
+	  lon[n] = net->gauge[i]->h.lon;
+	  n++;
+	}
+  }
+  ix = Gnew_site_index(n, lat, lon, cell_km);
+  free(lat);
+  free(lon);
+  if (ix == NULL)
+	free(gauge);
+  else
+	ix->gauge = gauge;
+  return ix;
+}
+
+void Gset_site_index_radar(Gsite_index *ix, float radar_lat, float radar_lon)
+{
+  /* The radar for the *_polar queries. */
+  if (ix == NULL) return;
+  ix->radar_lat = radar_lat;
+  ix->radar_lon = radar_lon;
+  ix->has_radar = 1;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                      Gsites_within                        */
+/*                                                           */
+/*************************************************************/
+int Gsites_within(Gsite_index *ix, float lat, float lon, float radius,
+				  int max, int *site, float *dist)
+{
+  /* The sites at most 'radius' km from (lat, lon), in no particular
+	 order: site[0..] and, if 'dist' is not NULL, their distances in
+	 km dist[0..].  At most 'max' are stored.
+
+	 Returns: the number of such sites (possibly more than 'max').
+	          ABORT, if ix is NULL.
+  */
+  double d, half_lat, half_lon, abs_lat;
+  int x, y, x0, x1, y0, y1, c, k, i, n;
+
+  if (ix == NULL) return ABORT;
+  if (ix->nsite == 0 || radius < 0) return 0;
+  half_lat = radius/KM_PER_DEG;
+  abs_lat = fabs(lat) + half_lat;
+  if (abs_lat >= 89.0) half_lon = 360.0;   /* Near a pole: every lon. */
+  else half_lon = radius/lon_km_per_deg(abs_lat);
+
+  y0 = (int)floor((lat - half_lat - ix->lat0)/ix->dlat);
+  y1 = (int)floor((lat + half_lat - ix->lat0)/ix->dlat);
+  x0 = (int)floor((lon - half_lon - ix->lon0)/ix->dlon);
+  x1 = (int)floor((lon + half_lon - ix->lon0)/ix->dlon);
+  if (y1 < 0 || x1 < 0 || y0 >= ix->ny || x0 >= ix->nx) return 0;
+  if (y0 < 0) y0 = 0;
+  if (x0 < 0) x0 = 0;
+  if (y1 >= ix->ny) y1 = ix->ny-1;
+  if (x1 >= ix->nx) x1 = ix->nx-1;
+
+  n = 0;
+  for (y=y0; y<=y1; y++)
+	for (x=x0; x<=x1; x++) {
+	  c = y*ix->nx + x;
+	  for (k=ix->start[c]; k<ix->start[c+1]; k++) {
+		i = ix->site[k];
+		d = site_distance(lat, lon, ix->lat[i], ix->lon[i]);
+		if (d > radius) continue;
+		if (n < max) {
+		  site[n] = i;
+		  if (dist) dist[n] = d;
+		}
+		n++;
+	  }
+	}
+  return n;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                      Gsites_nearest                       */
+/*                                                           */
+/*************************************************************/
+int Gsites_nearest(Gsite_index *ix, float lat, float lon, int k,
+				   int *site, float *dist)
+{
+  /* The 'k' sites nearest to (lat, lon), nearest first: site[0..k-1]
+	 and, if 'dist' is not NULL, their distances in km.  Ties go to
+	 the lower site number.
+
+	 Returns: the number of sites stored: k, or all of them if there
+	          are fewer.
+	          ABORT, if ix is NULL.
+  */
+  float best_d[64], *bd;
+  int best_s[64], *bs;
+  double d, reach;
+  int cx, cy, x, y, r, c, m, i, j, n, ring_done;
+
+  if (ix == NULL) return ABORT;
+  if (k > ix->nsite) k = ix->nsite;
+  if (k <= 0) return 0;
+  bd = best_d;
+  bs = best_s;
+  if (k > 64) {
+	bd = (float *)malloc(k*sizeof(float));
+	bs = (int *)malloc(k*sizeof(int));
+	if (bd == NULL || bs == NULL) {
+	  perror("Gsites_nearest");
+	  if (bd) free(bd);
+	  if (bs) free(bs);
+	  return ABORT;
+	}
+  }
+
+  /* Rings of cells around the query's cell.  After ring r, every site
+	 not yet seen is at least r cells away. */
+  c = Gsite_index_cell(ix, lat, lon);
+  cy = c / ix->nx;
+  cx = c % ix->nx;
+  n = 0;
+  for (r=0; ; r++) {
+	ring_done = 1;
+	for (y=cy-r; y<=cy+r; y++) {
+	  if (y < 0 || y >= ix->ny) continue;
+	  for (x=cx-r; x<=cx+r; x++) {
+		if (x < 0 || x >= ix->nx) continue;
+		if (y != cy-r && y != cy+r && x != cx-r && x != cx+r) continue;
+		ring_done = 0;
+		c = y*ix->nx + x;
+		for (m=ix->start[c]; m<ix->start[c+1]; m++) {
+		  i = ix->site[m];
+		  d = site_distance(lat, lon, ix->lat[i], ix->lon[i]);
+		  if (n == k && (d > bd[n-1] || (d == bd[n-1] && i > bs[n-1])))
+			continue;
+		  /* Insert, keeping bd[] ascending. */
+		  if (n < k) n++;
+		  for (j=n-1; j>0 && (bd[j-1] > d || (bd[j-1] == d && bs[j-1] > i)); j--) {
+			bd[j] = bd[j-1];
+			bs[j] = bs[j-1];
+		  }
+		  bd[j] = d;
+		  bs[j] = i;
+		}
+	  }
+	}
+	if (ring_done) break;  /* Past the edges of the grid. */
+	reach = r*ix->cell_km;
+	if (n == k && bd[n-1] <= reach) break;
+  }
+
+  for (j=0; j<n; j++) {
+	site[j] = bs[j];
+	if (dist) dist[j] = bd[j];
+  }
+  if (bd != best_d) {
+	free(bd);
+	free(bs);
+  }
+  return n;
+}
+
+/*************************************************************/
+/*                                                           */
+/*           Gsites_within_polar / Gsites_nearest_polar      */
+/*                                                           */
+/*************************************************************/
+int Gsites_within_polar(Gsite_index *ix, float range, float azimuth,
+						float radius, int max, int *site, float *dist)
+{
+  /* Gsites_within for the point at 'range' km and 'azimuth' degrees
+	 from the radar set by Gset_site_index_radar. */
+  float lat, lon;
+
+  if (ix == NULL || !ix->has_radar) return ABORT;
+  polar_to_latlon(ix->radar_lat, ix->radar_lon, range, azimuth, &lat, &lon);
+  return Gsites_within(ix, lat, lon, radius, max, site, dist);
+}
+
+int Gsites_nearest_polar(Gsite_index *ix, float range, float azimuth, int k,
+						 int *site, float *dist)
+{
+  /* Gsites_nearest for a point in the radar's frame. */
+  float lat, lon;
+
+  if (ix == NULL || !ix->has_radar) return ABORT;
+  polar_to_latlon(ix->radar_lat, ix->radar_lon, range, azimuth, &lat, &lon);
+  return Gsites_nearest(ix, lat, lon, k, site, dist);
+}
@@ -0,0 +1,159 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************
+
+	Runs independent GSL jobs (one per gauge file, per gauge, ...)
+	on a small pool of threads.
+
+	Workers take the next unclaimed job from a shared counter, so a
+	thread that finishes a short job immediately moves on to another
+	one and long jobs never hold up the rest of the pool.  Without
+	POSIX threads the jobs simply run one after the other.
+
+  -----------------------------------------------------------------
+	 Libraries required for execution of this code :
+      -lpthread                    : POSIX threads (optional)
+
+*******************************************************************/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
+#include "gsl.h"
+
+#define MAX_THREADS 256
+
+typedef struct {
+  void (*job)(int i, void *arg);
+  void *arg;
+  int   njob;
+  int   next;            /* Next unclaimed job. */
+#ifdef HAVE_LIBPTHREAD
+  int   threaded;        /* Nonzero when 'lock' is in use. */
+  pthread_mutex_t lock;
+#endif
+} Job_queue;
+
+/*************************************************************/
+/*                                                           */
+/*                     Gnumber_of_threads                    */
+/*                                                           */
+/*************************************************************/
+int Gnumber_of_threads(int nthread)
+{
+  /* The number of threads to use when the caller asked for 'nthread'.
+	 nthread <= 0 means one per online processor.
+  */
+#ifdef HAVE_LIBPTHREAD
+  long ncpu = 1;
+
+  if (nthread > 0) return (nthread > MAX_THREADS) ? MAX_THREADS : nthread;
+#ifdef _SC_NPROCESSORS_ONLN
+  ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (ncpu < 1) ncpu = 1;
+  if (ncpu > MAX_THREADS) ncpu = MAX_THREADS;
+  return (int)ncpu;
+#else
+  return 1;
+#endif
+}
+
+static void *run_jobs(void *qp)
+{
+  Job_queue *q = (Job_queue *)qp;
+  int i;
+
+  for (;;) {
+#ifdef HAVE_LIBPTHREAD
+	if (q->threaded) pthread_mutex_lock(&q->lock);
+#endif
+	i = q->next++;
+#ifdef HAVE_LIBPTHREAD
+	if (q->threaded) pthread_mutex_unlock(&q->lock);
+#endif
+	if (i >= q->njob) break;
+	q->job(i, q->arg);
+  }
+  return NULL;
+}
+
+/*************************************************************/
+/*                                                           */
+/*                       Gparallel_for                       */
+/*                                                           */
+/*************************************************************/
+int Gparallel_for(int njob, int nthread, void (*job)(int i, void *arg),
+				  void *arg)
+{
+  /* Calls job(i, arg) once for every i in 0..njob-1, using up to
+	 'nthread' threads (see Gnumber_of_threads).  Jobs may run in any
+	 order and must not depend on each other.  Returns when all jobs
+	 are done.  The calling thread works on the jobs too, so they
+	 all get done even if no extra thread can be started.
+
+	 Returns: OK.
+  */
+  Job_queue q;
+#ifdef HAVE_LIBPTHREAD
+  pthread_t tid[MAX_THREADS];
+  int j, nstarted;
+#endif
+
+  if (njob <= 0) return(OK);
+  q.job  = job;
+  q.arg  = arg;
+  q.njob = njob;
+  q.next = 0;
+#ifdef HAVE_LIBPTHREAD
+  q.threaded = 0;
+#endif
+  nthread = Gnumber_of_threads(nthread);
+  if (nthread > njob) nthread = njob;
+
+#ifdef HAVE_LIBPTHREAD
+  if (nthread > 1) {
+	pthread_mutex_init(&q.lock, NULL);
+	q.threaded = 1;
+	/* The calling thread is worker 0. */
+	for (nstarted=1; nstarted<nthread; nstarted++)
+	  if (pthread_create(&tid[nstarted], NULL, run_jobs, &q) != 0) {
+		perror("Gparallel_for -- pthread_create");
+		break;
+	  }
+	run_jobs(&q);
+	for (j=1; j<nstarted; j++)
+	  pthread_join(tid[j], NULL);
+	pthread_mutex_destroy(&q.lock);
+	return(OK);
+  }
+#endif
+  run_jobs(&q);
+  return(OK);
+}
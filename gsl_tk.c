@@ -0,0 +1,226 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************
+
+	Stand-in for the TSDIS toolkit granule calls, used when the
+	library is built without -ltsdistk; see gsl_tk.h.
+
+	The file is
+
+	    "GSLTK 1\n"              8 bytes
+	    productID, nnet          int, int
+	    NETDESC[nnet]
+	    one L2A_56_RAINGAUGE or L2A_57_DISDROMETER per gauge,
+	    network 0 first
+
+	in the byte order and structure layout of the host, so it is only
+	read back by the machine (and build) that wrote it.  As with the
+	toolkit, the net header is written before any gauge and the gauges
+	are read and written in order; asking for more gauges than the net
+	header announced is an error.  TKseekGauge, which the toolkit does
+	not have, moves a read handle to any gauge.
+
+*******************************************************************/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#ifndef HAVE_LIBTSDISTK
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gsl.h"
+#include "gsl_tk.h"
+
+#define TK_MAGIC "GSLTK 1\n"
+
+static size_t gauge_size(IO_HANDLE *ioh)
+{
+  return (ioh->productID == TK_L2A_57) ? sizeof(L2A_57_DISDROMETER)
+	                                   : sizeof(L2A_56_RAINGAUGE);
+}
+
+/*************************************************************/
+/*                                                           */
+/*                     TKopen / TKclose                      */
+/*                                                           */
+/*************************************************************/
+int TKopen(char *file, int productID, int mode, IO_HANDLE *ioh)
+{
+  char magic[8];
+  int id;
+
+  if (file == NULL || ioh == NULL) return TK_FAIL;
+  memset(ioh, 0, sizeof(IO_HANDLE));
+  if (productID != TK_L2A_56 && productID != TK_L2A_57) {
+	fprintf(stderr, "TKopen: %s: unknown product %d.\n", file, productID);
+	return TK_FAIL;
+  }
+  ioh->productID = productID;
+  ioh->mode = mode;
+  ioh->fp = fopen(file, (mode == TK_NEW_FILE) ? "wb" : "rb");
+  if (ioh->fp == NULL) {
+	perror(file);
+	return TK_FAIL;
+  }
+  if (mode == TK_NEW_FILE) return TK_SUCCESS;
+
+  if (fread(magic, sizeof(magic), 1, ioh->fp) != 1 ||
+	  memcmp(magic, TK_MAGIC, sizeof(magic)) != 0 ||
+	  fread(&id, sizeof(int), 1, ioh->fp) != 1 || id != productID) {
+	fprintf(stderr, "TKopen: %s: not a 2A-%d granule.\n", file, productID);
+	fclose(ioh->fp);
+	ioh->fp = NULL;
+	return TK_FAIL;
+  }
+  return TK_SUCCESS;
+}
+
+int TKclose(IO_HANDLE *ioh)
+{
+  int status = TK_SUCCESS;
+
+  if (ioh == NULL || ioh->fp == NULL) return TK_FAIL;
+  if (ioh->mode == TK_NEW_FILE && ioh->igauge != ioh->ngauge) {
+	fprintf(stderr, "TKclose: %d of %d gauges written.\n",
+			ioh->igauge, ioh->ngauge);
+	status = TK_FAIL;
+  }
+  if (fclose(ioh->fp) != 0) {
+	perror("TKclose");
+	status = TK_FAIL;
+  }
+  ioh->fp = NULL;
+  return status;
+}
+
+/*************************************************************/
+/*                                                           */
+/*              TKwriteNetHeader / TKreadNetHeader           */
+/*                                                           */
+/*************************************************************/
+int TKwriteNetHeader(IO_HANDLE *ioh, int nnet, NETDESC *netDesc)
+{
+  int j;
+
+  if (ioh == NULL || ioh->fp == NULL || ioh->mode != TK_NEW_FILE ||
+	  ftell(ioh->fp) != 0 || nnet < 0 || (nnet > 0 && netDesc == NULL))
+	return TK_FAIL;
+  if (fwrite(TK_MAGIC, 8, 1, ioh->fp) != 1 ||
+	  fwrite(&ioh->productID, sizeof(int), 1, ioh->fp) != 1 ||
+	  fwrite(&nnet, sizeof(int), 1, ioh->fp) != 1 ||
+	  (nnet > 0 && fwrite(netDesc, sizeof(NETDESC), nnet, ioh->fp) != nnet)) {
+	perror("TKwriteNetHeader");
+	return TK_FAIL;
+  }
+  ioh->ngauge = 0;
+  for (j=0; j<nnet; j++) ioh->ngauge += netDesc[j].nValidSensor;
+  return TK_SUCCESS;
+}
+
+int TKreadNetHeader(IO_HANDLE *ioh, int *nnet, NETDESC **netDesc)
+{
+  /* *netDesc is malloc'ed; the caller frees it. */
+  NETDESC *nd;
+  int j, n;
+
+  if (ioh == NULL || ioh->fp == NULL || ioh->mode != TK_READ_ONLY ||
+	  nnet == NULL || netDesc == NULL)
+	return TK_FAIL;
+  if (fread(&n, sizeof(int), 1, ioh->fp) != 1 || n < 0 ||
+	  n > MAX_GAUGE_NETWORKS) {
+	fprintf(stderr, "TKreadNetHeader: bad net header.\n");
+	return TK_FAIL;
+  }
+  nd = (NETDESC *)calloc(n > 0 ? n : 1, sizeof(NETDESC));
+  if (nd == NULL) {
+	perror("TKreadNetHeader");
+	return TK_FAIL;
+  }
+  if (n > 0 && fread(nd, sizeof(NETDESC), n, ioh->fp) != n) {
+	fprintf(stderr, "TKreadNetHeader: short net header.\n");
+	free(nd);
+	return TK_FAIL;
+  }
+  ioh->ngauge = 0;
+  for (j=0; j<n; j++) ioh->ngauge += nd[j].nValidSensor;
+  ioh->gauge_start = ftell(ioh->fp);
+  *nnet = n;
+  *netDesc = nd;
+  return TK_SUCCESS;
+}
+
+/*************************************************************/
+/*                                                           */
+/*          TKwriteGauge / TKreadGauge / TKseekGauge         */
+/*                                                           */
+/*************************************************************/
+int TKwriteGauge(IO_HANDLE *ioh, void *l2astr)
+{
+  /* 'l2astr' is an L2A_56_RAINGAUGE or L2A_57_DISDROMETER, as opened. */
+  if (ioh == NULL || ioh->fp == NULL || ioh->mode != TK_NEW_FILE ||
+	  l2astr == NULL || ioh->igauge >= ioh->ngauge)
+	return TK_FAIL;
+  if (fwrite(l2astr, gauge_size(ioh), 1, ioh->fp) != 1) {
+	perror("TKwriteGauge");
+	return TK_FAIL;
+  }
+  ioh->igauge++;
+  return TK_SUCCESS;
+}
+
+int TKreadGauge(IO_HANDLE *ioh, void *l2astr)
+{
+  if (ioh == NULL || ioh->fp == NULL || ioh->mode != TK_READ_ONLY ||
+	  l2astr == NULL || ioh->igauge >= ioh->ngauge)
+	return TK_FAIL;
+  if (fread(l2astr, gauge_size(ioh), 1, ioh->fp) != 1) {
+	fprintf(stderr, "TKreadGauge: short gauge %d.\n", ioh->igauge);
+	return TK_FAIL;
+  }
+  ioh->igauge++;
+  return TK_SUCCESS;
+}
+
+int TKseekGauge(IO_HANDLE *ioh, int igauge)
+{
+  /* The next TKreadGauge reads gauge 'igauge' (0 is the first gauge
+	 of the first network). */
+  if (ioh == NULL || ioh->fp == NULL || ioh->mode != TK_READ_ONLY ||
+	  ioh->gauge_start == 0 || igauge < 0 || igauge > ioh->ngauge)
+	return TK_FAIL;
+  if (fseek(ioh->fp, ioh->gauge_start + (long)igauge*gauge_size(ioh),
+			SEEK_SET) != 0) {
+	perror("TKseekGauge");
+	return TK_FAIL;
+  }
+  ioh->igauge = igauge;
+  return TK_SUCCESS;
+}
+
+void TKreportError(int status)
+{
+  fprintf(stderr, "TK error: status %d.\n", status);
+}
+
+#endif
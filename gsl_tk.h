@@ -0,0 +1,162 @@
+/*
+    NASA/TRMM, Code 910.1.
+    This is the TRMM Office Gauge Software Library.
+    Copyright (C) 1996  John Merritt, Mike Kolander of
+		                    Applied Research Corporation,
+                        Landover, Maryland, a NASA/GSFC on-site contractor.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the Free
+    Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/******************************************************************/
+/*
+ * The TSDIS toolkit calls used by gsl_to_hdf.c and hdf_to_gsl.c.
+ *
+ * With the toolkit (HAVE_LIBTSDISTK) this is just its headers.
+ * Without it, gsl_tk.c supplies a stand-in with the same calls and
+ * the same 2A-56/2A-57 structures, writing a plain local file instead
+ * of HDF: a net header followed by one raw L2A_56_RAINGAUGE or
+ * L2A_57_DISDROMETER per gauge, in network order.  That is enough to
+ * run, test and time the GSL side of the granule code anywhere.
+ *
+ ********************************************************************/
+#ifndef __GSL_TK_H__
+#define __GSL_TK_H__ 1
+
+#ifdef HAVE_LIBTSDISTK
+
+/* HDF 4.0r2 and TSDIS TOOLKIT 4.* */
+#include "IO.h"
+#include "IO_GV.h"
+#include "TKerrHandle.h"
+
+#else
+
+#include <stdio.h>
+
+#define TK_SUCCESS    0
+#define TK_FAIL      -1
+
+#define TK_L2A_56    56   /* Raingauge granule. */
+#define TK_L2A_57    57   /* Disdrometer granule. */
+
+#define TK_READ_ONLY  0
+#define TK_NEW_FILE   1
+
+#define TK_MAX_OBS   1440 /* One observation per minute for 24 hrs. */
+#define TK_NBIN      20   /* Disdrometer size classes. */
+
+typedef short int16;
+
+typedef struct {
+  char networkName[22];
+  int  nValidSensor;      /* Gauges of this network in the file. */
+  int  networkID;
+} NETDESC;
+
+typedef struct {
+  int   networkID;
+  char  gaugeType[22];
+  char  gaugeName[22];
+  char  gaugeMakeModel[22];
+  int   gaugeNumber;
+  float gaugeLat;
+  float gaugeLong;
+  float range;
+  float azimuth;
+  float xCoordinate;
+  float yCoordinate;
+  float resolution;
+  float elevation;
+} GAUGEDESC;
+
+typedef struct {
+  GAUGEDESC gaugeDesc;
+  int16     hour[TK_MAX_OBS];
+  int16     minute[TK_MAX_OBS];
+  float     meanRainRate_scale[TK_MAX_OBS];
+  float     meanRainRate[TK_MAX_OBS];
+} L2A_56_RAINGAUGE;
+
+typedef struct {
+  int   networkID;
+  char  disdroName[22];
+  char  disdroMakeModel[22];
+  int   disdroNumber;
+  float disdroLat;
+  float disdroLong;
+  float range;
+  float azimuth;
+  float resolution;
+  float elevation;
+} DISDRODESC;
+
+typedef struct {
+  DISDRODESC disdroDesc;
+  int16      hour[TK_MAX_OBS];
+  int16      minute[TK_MAX_OBS];
+  int16      nConcentration[TK_MAX_OBS][TK_NBIN];
+} L2A_57_DISDROMETER;
+
+typedef struct {
+  int   productID;        /* TK_L2A_56 or TK_L2A_57 */
+  int   mode;             /* TK_READ_ONLY or TK_NEW_FILE */
+  FILE *fp;
+  int   ngauge;           /* Gauges announced by the net header ... */
+  int   igauge;           /* ... and read/written so far. */
+  long  gauge_start;      /* File offset of gauge 0. */
+} IO_HANDLE;
+
+int  TKopen(char *file, int productID, int mode, IO_HANDLE *ioh);
+int  TKclose(IO_HANDLE *ioh);
+int  TKwriteNetHeader(IO_HANDLE *ioh, int nnet, NETDESC *netDesc);
+int  TKreadNetHeader(IO_HANDLE *ioh, int *nnet, NETDESC **netDesc);
+int  TKwriteGauge(IO_HANDLE *ioh, void *l2astr);
+int  TKreadGauge(IO_HANDLE *ioh, void *l2astr);
+int  TKseekGauge(IO_HANDLE *ioh, int igauge); /* Stand-in only. */
+void TKreportError(int status);
+
+#endif
+
+/* The records of one gauge that go into one granule: record
+ * order[first..first+nobs-1], or record[first..first+nobs-1] when
+ * 'order' is NULL.  nobs < 0 leaves the gauge out of the granule.
+ */
+typedef struct {
+  int *order;
+  int  first;
+  int  nobs;
+} Granule_gauge;
+
+/* One L2A structure reused for all the gauges of a granule; see
+ * gsl_l2a.c.
+ */
+typedef struct {
+  int   productType;  /* TK_L2A_56 or TK_L2A_57 */
+  void *l2a;          /* The structure, 16-byte aligned. */
+  int   nused;        /* Slots in use; all later ones are zero. */
+  char *mem;
+} L2A_stage;
+
+int        l2a_fill(void *l2a, int productType, Gauge *gauge,
+					Granule_gauge *gg, int networkID, int nclear);
+Gauge     *l2a_to_gauge(void *l2a, int productType, Gtime_key day);
+L2A_stage *new_l2a_stage(int productType);
+void       free_l2a_stage(L2A_stage *st);
+int        stage_gauge(L2A_stage *st, Gauge *gauge, Granule_gauge *gg,
+					   int networkID);
+void       clear_stage(L2A_stage *st);
+
+#endif
@@ -32,10 +32,13 @@
 	from any number of raingauges from any number of raingauge networks
 	located at one radar site.
 
+	Gauge_complex_to_hdf_by_day splits a Gauge_complex covering several
+	days into one granule per day.
+
 
   -----------------------------------------------------------------
 	 Libraries required for execution of this code :
-      -ltsdistk                    : tsdis toolkit
+      -ltsdistk                    : tsdis toolkit (optional; see gsl_tk.h)
       -lmfhdf -ldf -ljpeg -lz      : HDF
 
   -----------------------------------------------------------------
@@ -45,16 +48,12 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
-#ifdef HAVE_LIBTSDISTK
-
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "gsl.h"
-
-/* HDF 4.0r2 and TSDIS TOOLKIT 4.* */
-#include "IO.h"
-#include "IO_GV.h"
+#include "gsl_tk.h"
 
 
 int fill_l2a56(L2A_56_RAINGAUGE *l2a56, Gauge *gauge, int networkID);
@@ -74,59 +73,16 @@ int fill_l2a56(L2A_56_RAINGAUGE *l2a56, Gauge *gauge, int networkID)
 		 Returns: OK, if success.
 		          ABORT, if fail.
   */
-	int j, n, this_jday;
-	
+	Granule_gauge gg;
+
 	if (gauge == NULL) return(ABORT);
 	/* Zero out the L2A_56_RAINGAUGE structure before we move
 	   any data into it... Many Gauges are only partly full. */
 	memset(l2a56, 0, sizeof(L2A_56_RAINGAUGE));
-			
-	l2a56->gaugeDesc.networkID = networkID;
-	n = strlen(gauge->h.type);
-	if (n > 21) n = 21;
-	strncpy(l2a56->gaugeDesc.gaugeType, gauge->h.type, n);
-	n = strlen(gauge->h.name);
-	if (n > 21) n = 21;
-	strncpy(l2a56->gaugeDesc.gaugeName, gauge->h.name, n);
-	n = 21;
-	memset(l2a56->gaugeDesc.gaugeMakeModel, 0, n); /* N/A */
-	l2a56->gaugeDesc.gaugeNumber  = gauge->h.number;
-	l2a56->gaugeDesc.gaugeLat     = gauge->h.lat;
-	l2a56->gaugeDesc.gaugeLong    = gauge->h.lon;
-	l2a56->gaugeDesc.range        = gauge->h.range;
-	l2a56->gaugeDesc.azimuth      = gauge->h.azimuth;
-	l2a56->gaugeDesc.xCoordinate  = 0;
-	l2a56->gaugeDesc.yCoordinate  = 0;
-	l2a56->gaugeDesc.resolution   = gauge->h.resolution;
-	l2a56->gaugeDesc.elevation    = gauge->h.elevation;
-	  
-	/* The number of observations cannot exceed 1440 (24hr*60min/hr). */
-	if (gauge->h.nobs > 1440)
-	{
-		fprintf(stderr, "gauge->h.nobs = %d ... exceeds HDF limit of 1440.\n",
-						gauge->h.nobs);
-		return(ABORT);
-	} 
-
-	this_jday = gauge->record[0].time.jday;
-	for (j=0; j<gauge->h.nobs; j++)
-	{
-		if (gauge->record[j].time.jday == this_jday)
-		{
-			l2a56->hour[j]               = gauge->record[j].time.hour;
-			l2a56->minute[j]             = gauge->record[j].time.minute;
-			/* Don't touch l2a56->meanRainRate_scale[j] */
-			/*		  l2a56->meanRainRate[j]       = gauge->record[j].rate; */
-			l2a56->meanRainRate[j]       = gauge->record[j].value[0];
-		}
-		else  /* Observations not all from same day */
-		{
-			fprintf(stderr, "Raingauge observations not all from same day.\n");
-			return(ABORT);
-		}
-	}  /* end for (j=0; j<gauge->h.nobs; j++) */
-
-	return(OK);
+	gg.order = NULL;
+	gg.first = 0;
+	gg.nobs  = gauge->h.nobs;
+	return(l2a_fill(l2a56, TK_L2A_56, gauge, &gg, networkID, 0));
 }
 
 /***********************************************************/
@@ -136,53 +92,16 @@ int fill_l2a56(L2A_56_RAINGAUGE *l2a56, Gauge *gauge, int networkID)
 /***********************************************************/
 int fill_l2a57(L2A_57_DISDROMETER *l2a57, Gauge *gauge, int networkID)
 {
-	int j, k, n, this_jday;
+	Granule_gauge gg;
 
 	if (gauge == NULL) return(ABORT);
 	/* Zero out the L2A_57_DISDROMETER structure before we move
 	   any data into it... Many Gauges are only partly full. */
 	memset(l2a57, 0, sizeof(L2A_57_DISDROMETER));
-
-	l2a57->disdroDesc.networkID = networkID;
-	n = strlen(gauge->h.name);
-	if (n > 21) n = 21;
-	strncpy(l2a57->disdroDesc.disdroName, gauge->h.name, n);
-	n = 21;
-	memset(l2a57->disdroDesc.disdroMakeModel, 0, n); /* N/A */
-	l2a57->disdroDesc.disdroNumber  = gauge->h.number;
-	l2a57->disdroDesc.disdroLat     = gauge->h.lat;
-	l2a57->disdroDesc.disdroLong    = gauge->h.lon;
-	l2a57->disdroDesc.range        = gauge->h.range;
-	l2a57->disdroDesc.azimuth      = gauge->h.azimuth;
-	l2a57->disdroDesc.resolution   = gauge->h.resolution;
-	l2a57->disdroDesc.elevation    = gauge->h.elevation;
-	  
-	/* The number of observations cannot exceed 1440 (24hr*60min/hr). */
-	if (gauge->h.nobs > 1440)
-	{
-		fprintf(stderr, "gauge->h.nobs = %d ... exceeds HDF limit of 1440.\n",
-						gauge->h.nobs);
-		return(ABORT);
-	}
-
-	this_jday = gauge->record[0].time.jday;
-	for (j=0; j<gauge->h.nobs; j++)
-	{
-		if (gauge->record[j].time.jday == this_jday)
-		{
-			l2a57->hour[j]               = gauge->record[j].time.hour;
-			l2a57->minute[j]             = gauge->record[j].time.minute;
-			for (k=0; k<gauge->h.nbin; k++)
-			  l2a57->nConcentration[j][k] = (int16)gauge->record[j].value[k];
-		}
-		else  /* Observations not all from same day. */
-		{
-			fprintf(stderr, "Disdrometer observations not all from same day.\n");
-			return(ABORT);
-		}
-	}  /* end for (j=0; j<gauge->h.nobs; j++) */
-
-	return(OK);
+	gg.order = NULL;
+	gg.first = 0;
+	gg.nobs  = gauge->h.nobs;
+	return(l2a_fill(l2a57, TK_L2A_57, gauge, &gg, networkID, 0));
 }
 
 /***********************************************************/
@@ -195,16 +114,14 @@ NETDESC *build_netDesc(Gauge_complex *gcomplex)
 	/* Create and fill an array of toolkit 'NETDESC' structures,
 		 one per network.
 	*/
-	int j, n;
+	int j;
 	NETDESC *netDesc;
 	
 	netDesc = (NETDESC *)calloc(gcomplex->h.nnet, sizeof(NETDESC));
 	if (netDesc == NULL) return(NULL);
 	for (j=0; j<gcomplex->h.nnet; j++)
 	{
-		n = strlen(gcomplex->net[j]->h.name);
-		if (n > 21) n = 21;
-		strncpy(netDesc[j].networkName, gcomplex->net[j]->h.name, n);
+		strncpy(netDesc[j].networkName, gcomplex->net[j]->h.name, 21);
 		netDesc[j].nValidSensor = gcomplex->net[j]->h.ngauge;
 		netDesc[j].networkID = j;
 	}
@@ -214,81 +131,360 @@ NETDESC *build_netDesc(Gauge_complex *gcomplex)
 
 /***********************************************************/
 /*                                                         */
-/*                    Gauge_complex_to_hdf                 */
+/*                       write_granule                     */
 /*                                                         */
 /***********************************************************/
-int Gauge_complex_to_hdf(Gauge_complex *gcomplex, char *hdffile)
+static int write_granule(Gauge_complex *gcomplex, Granule_gauge *gg,
+						 int productType, char *hdffile)
 {
-	/*
-		 Moves one granule (24 hrs) of raingauge or disdrometer data
-		 from one GSL 'Gauge_complex' structure into one HDF file.
-
-		 Checks granule integrity; ie, checks that all gauge observations
-		 in the Gauge_complex structure are from the same 24 hr period.
+	/* Writes the records picked by gg[] (one entry per gauge of
+		 'gcomplex', network 0 first) into one HDF file.  Networks with
+		 no gauge in the granule are left out.
 
 		 Returns: OK, if success.
 		          ABORT, if failure.
 	*/
   IO_HANDLE ioh;
 	NETDESC   *netDesc; /* Pointer to an array of NETDESC structures.*/
-	L2A_57_DISDROMETER l2a57;
-  L2A_56_RAINGAUGE   l2a56;
-	int i, j, productType, status;
-	
-  if (gcomplex->net[0] == NULL) return(ABORT);
-  if (hdffile == NULL) return(ABORT);
+	L2A_stage *stage;   /* The 'l2a56' or 'l2a57' structure. */
+	Gauge_network *net;
+	int i, j, k, n, nnet, status;
 
-  if (strcmp(gcomplex->net[0]->h.type, "DSD") == 0)
-	  productType = TK_L2A_57;  /* Disdrometer */
-	else
-	  productType = TK_L2A_56;  /* Raingauge */
+	/* Move header info from each Gauge_network into a toolkit
+		 'NETDESC' structure. */
+	netDesc = (NETDESC *)calloc(gcomplex->h.nnet + 1, sizeof(NETDESC));
+	stage = new_l2a_stage(productType);
+	if (netDesc == NULL || stage == NULL)
+	{
+		fprintf(stderr, "Gauge_complex_to_hdf(): Error creating 'netDesc' structure\n");
+		if (netDesc) free(netDesc);
+		free_l2a_stage(stage);
+		return(ABORT);
+	}
+	nnet = 0;
+	for (j=k=0; j<gcomplex->h.nnet; k+=gcomplex->net[j]->h.ngauge, j++)
+	{
+		for (i=n=0; i<gcomplex->net[j]->h.ngauge; i++)
+			if (gg[k+i].nobs >= 0) n++;
+		if (n == 0) continue;
+		strncpy(netDesc[nnet].networkName, gcomplex->net[j]->h.name, 21);
+		netDesc[nnet].nValidSensor = n;
+		netDesc[nnet].networkID = nnet;
+		nnet++;
+	}
 
 	status = TKopen(hdffile, productType, TK_NEW_FILE, &ioh);
 	if (status != TK_SUCCESS)
 	{
 		fprintf(stderr, "Gauge_complex_to_hdf(): Error opening hdffile.\n");
+		free(netDesc);
+		free_l2a_stage(stage);
 		return(ABORT);
 	}
-	
-	/* Move header info from each Gauge_network into a toolkit
-		 'NETDESC' structure. Note 'build_netDesc()' returns an array
-		 of filled NETDESC structures. */
-	netDesc = (NETDESC *)build_netDesc(gcomplex);
-	if (netDesc == NULL)
-	{
-		fprintf(stderr, "Gauge_complex_to_hdf(): Error creating 'netDesc' structure\n");
-		goto quit;
-	}
 	/* Write the array of NETDESC structures into the HDF file. */
-	status = TKwriteNetHeader(&ioh, gcomplex->h.nnet, netDesc);
+	status = TKwriteNetHeader(&ioh, nnet, netDesc);
 	if (status != TK_SUCCESS) goto quit;
 
 	/* Write each gauge_network from the GSL structure into the HDF file.*/
-	for (j=0; j<gcomplex->h.nnet; j++)
+	nnet = 0;
+	for (j=k=0; j<gcomplex->h.nnet && status == TK_SUCCESS;
+			 k+=net->h.ngauge, j++)
 	{
-		/* Write each gauge of one network into a toolkit 'l2a56' or
-			 'l2a57' structure, then into the HDF file. */
-		if (productType == TK_L2A_56)  /* Raingauge */
-			for (i=0; i<gcomplex->net[j]->h.ngauge; i++)
-			{ 
-				status = fill_l2a56(&l2a56, gcomplex->net[j]->gauge[i], j);
-				if (status != OK) break;
-				status = TKwriteGauge(&ioh, &l2a56);
-				if (status != TK_SUCCESS) break;
-			}		
-		else  /* Disdrometer */
-			for (i=0; i<gcomplex->net[j]->h.ngauge; i++)
-			{ 
-				status = fill_l2a57(&l2a57, gcomplex->net[j]->gauge[i], j);
-				if (status != OK) break;
-				status = TKwriteGauge(&ioh, &l2a57);
-				if (status != TK_SUCCESS) break;
-			}
+		net = gcomplex->net[j];
+		for (i=n=0; i<net->h.ngauge; i++)
+		{
+			if (gg[k+i].nobs < 0) continue;
+			n++;
+			/* Write each gauge of one network into a toolkit 'l2a56' or
+				 'l2a57' structure, then into the HDF file. */
+			status = stage_gauge(stage, net->gauge[i], &gg[k+i], nnet);
+			if (status == OK) status = TKwriteGauge(&ioh, stage->l2a);
+			if (status != TK_SUCCESS) break;
+		}
+		if (n > 0) nnet++;
 	} /* end for (j=0; j<gcomplex->nnet; j++) */
 
  quit:
-	TKclose(&ioh);
+	free(netDesc);
+	free_l2a_stage(stage);
+	if (TKclose(&ioh) != TK_SUCCESS) status = TK_FAIL;
 	if (status == TK_SUCCESS) return(OK);
-	else return(ABORT);
+	/* Leave no partial granule behind. */
+	remove(hdffile);
+	return(ABORT);
+}
+
+static int hdf_product_type(Gauge_complex *gcomplex)
+{
+  char *type = gcomplex->net[0]->h.type;
+
+  if (type != NULL && strcmp(type, "DSD") == 0)
+	  return(TK_L2A_57);  /* Disdrometer */
+	else
+	  return(TK_L2A_56);  /* Raingauge */
+}
+
+static int complex_ngauge(Gauge_complex *gcomplex)
+{
+	int j, n;
+
+	for (j=n=0; j<gcomplex->h.nnet; j++)
+		n += gcomplex->net[j]->h.ngauge;
+	return(n);
+}
+
+/***********************************************************/
+/*                                                         */
+/*                    Gauge_complex_to_hdf                 */
+/*                                                         */
+/***********************************************************/
+int Gauge_complex_to_hdf(Gauge_complex *gcomplex, char *hdffile)
+{
+	/*
+		 Moves one granule (24 hrs) of raingauge or disdrometer data
+		 from one GSL 'Gauge_complex' structure into one HDF file.
+
+		 Checks granule integrity; ie, checks that all gauge observations
+		 in the Gauge_complex structure are from the same 24 hr period.
+		 See Gauge_complex_to_hdf_by_day for several days.
+
+		 Returns: OK, if success.
+		          ABORT, if failure.
+	*/
+	Granule_gauge *gg;
+	Gauge *g;
+	int i, j, k, status;
+	
+  if (gcomplex->net[0] == NULL) return(ABORT);
+  if (hdffile == NULL) return(ABORT);
+
+	/* Every gauge, whole. */
+	gg = (Granule_gauge *)calloc(complex_ngauge(gcomplex) + 1,
+															 sizeof(Granule_gauge));
+	if (gg == NULL)
+	{
+		perror("Gauge_complex_to_hdf");
+		return(ABORT);
+	}
+	for (j=k=0; j<gcomplex->h.nnet; j++)
+		for (i=0; i<gcomplex->net[j]->h.ngauge; i++, k++)
+		{
+			g = gcomplex->net[j]->gauge[i];
+			if (g == NULL)
+			{
+				fprintf(stderr, "Gauge_complex_to_hdf: gauge %d of network %s "
+								"not read.\n", i, gcomplex->net[j]->h.name);
+				free(gg);
+				return(ABORT);
+			}
+			Gcheck_gauge_time_keys(g);
+			gg[k].nobs = g->h.nobs;
+		}
+
+	status = write_granule(gcomplex, gg, hdf_product_type(gcomplex), hdffile);
+	free(gg);
+	return(status);
+}
+
+/***********************************************************/
+/*                                                         */
+/*                Gauge_complex_to_hdf_by_day              */
+/*                                                         */
+/***********************************************************/
+/* One day's worth of consecutive (time ordered) records of a gauge. */
+typedef struct {
+	long day;      /* Days since 1970-01-01. */
+	int  gauge;    /* Position in the complex, network 0 first. */
+	int  first;
+	int  nobs;
+} Day_run;
+
+typedef struct {
+	Gauge_complex *gcomplex;
+	int      ngauge;
+	int    **order;    /* order[k]: time order of gauge k, or NULL. */
+	Day_run *run;
+	int     *day_start; /* Granule d is run[day_start[d]..day_start[d+1]-1]. */
+	int      productType;
+	char    *dir;
+	char     site[16];
+	int     *status;   /* status[d]: write_granule of granule d. */
+} Day_granules;
+
+static long key_day(Gtime_key key)
+{
+	return (long)((key >= 0) ? key/GSL_DAY : -((-key + GSL_DAY - 1)/GSL_DAY));
+}
+
+static int compare_runs(const void *a, const void *b)
+{
+	const Day_run *ra = (const Day_run *)a;
+	const Day_run *rb = (const Day_run *)b;
+
+	if (ra->day != rb->day) return (ra->day < rb->day) ? -1 : 1;
+	return ra->gauge - rb->gauge;
+}
+
+static void write_day_granule(int d, void *arg)
+{
+	Day_granules *dg = (Day_granules *)arg;
+	Granule_gauge *gg;
+	Gauge_time t;
+	Day_run *r;
+	char *hdffile;
+	int k;
+
+	dg->status[d] = ABORT;
+	gg = (Granule_gauge *)malloc((dg->ngauge + 1)*sizeof(Granule_gauge));
+	hdffile = (char *)malloc(strlen(dg->dir) + strlen(dg->site) + 32);
+	if (gg == NULL || hdffile == NULL)
+	{
+		perror("Gauge_complex_to_hdf_by_day");
+		if (gg) free(gg);
+		if (hdffile) free(hdffile);
+		return;
+	}
+	for (k=0; k<dg->ngauge; k++)
+		gg[k].nobs = -1;
+	for (r = &dg->run[dg->day_start[d]]; r < &dg->run[dg->day_start[d+1]]; r++)
+	{
+		gg[r->gauge].order = dg->order[r->gauge];
+		gg[r->gauge].first = r->first;
+		gg[r->gauge].nobs  = r->nobs;
+	}
+
+	r = &dg->run[dg->day_start[d]];
+	Gkey_to_time((Gtime_key)r->day*GSL_DAY, &t);
+	sprintf(hdffile, "%s/%s.%02d%02d%02d.%s.hdf", dg->dir,
+					(dg->productType == TK_L2A_57) ? "2A57" : "2A56",
+					t.year % 100, t.month, t.day, dg->site);
+	dg->status[d] = write_granule(dg->gcomplex, gg, dg->productType, hdffile);
+	if (dg->status[d] != OK)
+		fprintf(stderr, "Gauge_complex_to_hdf_by_day(): %s not written.\n",
+						hdffile);
+	free(gg);
+	free(hdffile);
 }
+
+int Gauge_complex_to_hdf_by_day(Gauge_complex *gcomplex, char *dir,
+																int nthread)
+{
+	/*
+		 Writes the data of a Gauge_complex that covers any number of days
+		 as one granule per day, dir/2A56.yymmdd.<radarSite>.hdf (2A57 for
+		 disdrometers), as Gauge_complex_to_hdf would write each day.  A
+		 gauge is left out of the days it has no observations for.
+
+		 The gauges are split in one pass over their time ordered records;
+		 nothing is copied and 'gcomplex' is not changed.  Granules are
+		 written on up to 'nthread' threads (see Gparallel_for); with the
+		 TSDIS toolkit, which is not thread safe, one at a time.
+
+		 Returns: the number of granules written, if success.
+		          ABORT, if any granule could not be written (the others
+		                 still are).
+	*/
+	Day_granules dg;
+	Day_run *run, *new_run;
+	Gauge *g;
+	Gtime_key key;
+	int i, j, k, e, d, nrun, maxrun, ndays, nfail;
+	long day;
+	char *s;
+
+  if (gcomplex == NULL || gcomplex->net[0] == NULL) return(ABORT);
+  if (dir == NULL) return(ABORT);
+
+	memset(&dg, 0, sizeof(dg));
+	dg.gcomplex    = gcomplex;
+	dg.ngauge      = complex_ngauge(gcomplex);
+	dg.productType = hdf_product_type(gcomplex);
+	dg.dir         = dir;
+	strncpy(dg.site, gcomplex->h.radarSite ? gcomplex->h.radarSite : "NONE",
+					sizeof(dg.site) - 1);
+	for (s = dg.site; *s; s++)
+		if (*s == '/') *s = '_';   /* "N/A" */
+
+	dg.order = (int **)calloc(dg.ngauge + 1, sizeof(int *));
+	maxrun = dg.ngauge + 16;
+	run = (Day_run *)malloc(maxrun*sizeof(Day_run));
+	if (dg.order == NULL || run == NULL) goto oom;
+
+	/* Cut every gauge into runs of records from the same day. */
+	nrun = 0;
+	for (j=k=0; j<gcomplex->h.nnet; j++)
+		for (i=0; i<gcomplex->net[j]->h.ngauge; i++, k++)
+		{
+			g = gcomplex->net[j]->gauge[i];
+			if (g == NULL || g->h.nobs == 0) continue;
+			Gcheck_gauge_time_keys(g);
+			for (e=1; e<g->h.nobs; e++)
+				if (g->record[e-1].time.key > g->record[e].time.key) break;
+			if (e < g->h.nobs)
+			{
+				dg.order[k] = (int *)malloc(g->h.nobs*sizeof(int));
+				if (dg.order[k] == NULL ||
+						Gsort_gauge_order(g, dg.order[k]) != OK) goto oom;
+			}
+			for (e=0; e<g->h.nobs; )
+			{
+				if (nrun == maxrun)
+				{
+					maxrun *= 2;
+					new_run = (Day_run *)realloc(run, maxrun*sizeof(Day_run));
+					if (new_run == NULL) goto oom;
+					run = new_run;
+				}
+				run[nrun].gauge = k;
+				run[nrun].first = e;
+				key = g->record[dg.order[k] ? dg.order[k][e] : e].time.key;
+				run[nrun].day = day = key_day(key);
+				for (e++; e<g->h.nobs; e++)
+				{
+					key = g->record[dg.order[k] ? dg.order[k][e] : e].time.key;
+					if (key_day(key) != day) break;
+				}
+				run[nrun].nobs = e - run[nrun].first;
+				nrun++;
+			}
+		}
+
+	/* Group the runs by day: one granule each. */
+	qsort(run, nrun, sizeof(Day_run), compare_runs);
+	dg.run = run;
+	dg.day_start = (int *)malloc((nrun + 1)*sizeof(int));
+	dg.status    = (int *)malloc((nrun + 1)*sizeof(int));
+	if (dg.day_start == NULL || dg.status == NULL) goto oom;
+	for (e=ndays=0; e<nrun; e++)
+		if (e == 0 || run[e].day != run[e-1].day)
+			dg.day_start[ndays++] = e;
+	dg.day_start[ndays] = nrun;
+
+#ifdef HAVE_LIBTSDISTK
+	nthread = 1;
 #endif
+	Gparallel_for(ndays, nthread, write_day_granule, &dg);
+
+	for (d=nfail=0; d<ndays; d++)
+		if (dg.status[d] != OK) nfail++;
+	for (k=0; k<dg.ngauge; k++)
+		if (dg.order[k]) free(dg.order[k]);
+	free(dg.order);
+	free(run);
+	free(dg.day_start);
+	free(dg.status);
+	return (nfail == 0) ? ndays : ABORT;
+
+ oom:
+	perror("Gauge_complex_to_hdf_by_day");
+	if (dg.order)
+	{
+		for (k=0; k<dg.ngauge; k++)
+			if (dg.order[k]) free(dg.order[k]);
+		free(dg.order);
+	}
+	if (run) free(run);
+	if (dg.day_start) free(dg.day_start);
+	if (dg.status) free(dg.status);
+	return(ABORT);
+}
@@ -27,13 +27,16 @@
 
 	Similiarly, moves disdrometer data from one 2A-57 HDF file.
 
+	Gopen_hdf_complex reads only the network header of a file; gauges
+	are then read one at a time, as they are asked for, and kept.
+
 	A GSL 'Gauge_complex' structure contains data from all raingauges
 	from all raingauge networks at one radar site.
 
 
   -----------------------------------------------------------------
 	 Libraries required for execution of this code :
-      -ltsdistk                    : tsdis toolkit
+      -ltsdistk                    : tsdis toolkit (optional; see gsl_tk.h)
       -lmfhdf -ldf -ljpeg -lz      : HDF
       -lm                          : C math
 
@@ -44,26 +47,22 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
-#ifdef HAVE_LIBTSDISTK
 
 #include <string.h>
 #include <strings.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "gsl.h"
-/* HDF 4.0r2 and TSDIS TOOLKIT 4.* */
-#include "IO.h"
-#include "IO_GV.h"
-#include "TKerrHandle.h"
-
-Gauge *build_disdrogauge(L2A_57_DISDROMETER *l2a57);
-Gauge *build_raingauge(L2A_56_RAINGAUGE *l2a56);
-Gauge_network *build_gauge_network(IO_HANDLE *ioh, NETDESC *netDesc,
-																	 int productType);
+#include "gsl_tk.h"
+
+Gauge *build_disdrogauge(L2A_57_DISDROMETER *l2a57, Gtime_key day);
+Gauge *build_raingauge(L2A_56_RAINGAUGE *l2a56, Gtime_key day);
 Gauge_complex *Ghdf_to_gauge_complex(char *hdffile);
 
+#ifdef HAVE_LIBTSDISTK
 /***********************************************************************/
 /* The following 4 functions are temporary until TSDIS incorporates
-	 them into the toolkit. */
+	 them into the toolkit.  The stand-in toolkit (gsl_tk.c) has its own. */
 
 int TKreadRaingauge(IO_HANDLE *ioh, L2A_56_RAINGAUGE *l2astr)
 {
@@ -112,6 +111,7 @@ int TKreadNetHeader(IO_HANDLE *ioh, int *nnet, NETDESC **nDesc)
 }
 /***********************************************************************/
 #endif
+#endif
 
 
 /***********************************************************/
@@ -119,39 +119,15 @@ int TKreadNetHeader(IO_HANDLE *ioh, int *nnet, NETDESC **nDesc)
 /*                     build_disdrogauge                   */
 /*                                                         */
 /***********************************************************/
-Gauge *build_disdrogauge(L2A_57_DISDROMETER *l2a57)
+Gauge *build_disdrogauge(L2A_57_DISDROMETER *l2a57, Gtime_key day)
 {
 	Gauge *g;
-	int j, k, nobs;
-
-	/* Find out how many of the 1440 slots of the L2A_57_DISDROMETER
-		 structure are non-empty.
-		 Do this by searching from the end of the array for a non-zero time
-		 value. */
-	for (nobs=1440; nobs>0; nobs--)
-		if ( (l2a57->hour[nobs-1]) || (l2a57->minute[nobs-1])) break;
-	
-	/* Gauge contains 'nobs' observations, each consisting of 20 bins. */
-	g = (Gauge *)Gnew_gauge(nobs, 20);
-	g->h.number = l2a57->disdroDesc.disdroNumber;
-	g->h.name = (char *) strdup(l2a57->disdroDesc.disdroName);
-	g->h.type = (char *) strdup("DSD");
-	g->h.network = (char *) strdup("nnn");     /* ??? */
-	g->h.resolution = l2a57->disdroDesc.resolution;
-	g->h.lat = l2a57->disdroDesc.disdroLat;
-	g->h.lon = l2a57->disdroDesc.disdroLong;
-	g->h.azimuth = l2a57->disdroDesc.azimuth;
-	g->h.range = l2a57->disdroDesc.range;
-	g->h.elevation = l2a57->disdroDesc.elevation;
-	g->h.nobs = nobs;
-	g->h.nbin = 20;
-	for (j=0; j<g->h.nobs; j++)
-	{
-		g->record[j].time.hour = l2a57->hour[j];
-		g->record[j].time.minute = l2a57->minute[j];
-		for (k=0; k<g->h.nbin; k++)
-		  g->record[j].value[k] = l2a57->nConcentration[j][k];
-	}
+
+	/* Gauge contains as many observations as there are non-empty slots
+		 of the 1440 in the L2A_57_DISDROMETER structure, each consisting
+		 of 20 bins. */
+	g = l2a_to_gauge(l2a57, TK_L2A_57, day);
+	if (g == NULL) return(NULL);
 	fprintf(stderr, "DisdroGauge: %s contains %d recorded observations.\n",
 					g->h.name, g->h.nobs);
 	return(g);
@@ -162,38 +138,15 @@ Gauge *build_disdrogauge(L2A_57_DISDROMETER *l2a57)
 /*                     build_raingauge                     */
 /*                                                         */
 /***********************************************************/
-Gauge *build_raingauge(L2A_56_RAINGAUGE *l2a56)
+Gauge *build_raingauge(L2A_56_RAINGAUGE *l2a56, Gtime_key day)
 {
 	Gauge *g;
-	int j, nobs;
-	
-	/* Find out how many of the 1440 slots of the L2A_56_RAINGAUGE
-		 structure are non-empty.
-		 Do this by searching from the end of the array for a non-zero time
-		 value. */
-	for (nobs=1440; nobs>0; nobs--)
-		if ( (l2a56->hour[nobs-1]) || (l2a56->minute[nobs-1])) break;
 	
-	/* Gauge contains 'nobs' observations, each consisting of 1 bin. */
-	g = (Gauge *)Gnew_gauge(nobs, 1);
-	g->h.number = l2a56->gaugeDesc.gaugeNumber;
-	g->h.name = (char *) strdup(l2a56->gaugeDesc.gaugeName);
-	g->h.type = (char *) strdup(l2a56->gaugeDesc.gaugeType);
-	g->h.network = (char *) strdup("nnn");     /* ??? */
-	g->h.resolution = l2a56->gaugeDesc.resolution;
-	g->h.lat = l2a56->gaugeDesc.gaugeLat;
-	g->h.lon = l2a56->gaugeDesc.gaugeLong;
-	g->h.azimuth = l2a56->gaugeDesc.azimuth;
-	g->h.range = l2a56->gaugeDesc.range;
-	g->h.elevation = l2a56->gaugeDesc.elevation;
-	g->h.nobs = nobs;
-	g->h.nbin = 1;
-	for (j=0; j<g->h.nobs; j++)
-	{
-		g->record[j].time.hour = l2a56->hour[j];
-		g->record[j].time.minute = l2a56->minute[j];
-		g->record[j].value[0] = l2a56->meanRainRate[j];
-	}
+	/* Gauge contains as many observations as there are non-empty slots
+		 of the 1440 in the L2A_56_RAINGAUGE structure, each consisting
+		 of 1 bin. */
+	g = l2a_to_gauge(l2a56, TK_L2A_56, day);
+	if (g == NULL) return(NULL);
 	fprintf(stderr, "Raingauge: %s contains %d recorded observations.\n",
 					g->h.name, g->h.nobs);
 	return(g);
@@ -201,67 +154,98 @@ Gauge *build_raingauge(L2A_56_RAINGAUGE *l2a56)
 
 /***********************************************************/
 /*                                                         */
-/*                   build_gauge_network                   */
+/*                  open_granule / seek_gauge              */
 /*                                                         */
 /***********************************************************/
-Gauge_network *build_gauge_network(IO_HANDLE *ioh, NETDESC *netDesc,
-																	 int productType)
+static int open_granule(Ghdf_complex *hc, int *nnet, NETDESC **netDesc)
 {
-	Gauge_network *gnet;
-	L2A_57_DISDROMETER  l2a57;
-  L2A_56_RAINGAUGE    l2a56;
-	int j, status;
-	
-	gnet = Gnew_gauge_network(MAX_NETWORK_GAUGES);
-	if (gnet == NULL) return(NULL);
-
-	/* Read each gauge of one network from the HDF file into
-		 toolkit structure 'l2a56' or 'l2a56', then move into a GSL
-		 'Gauge' structure. */
-	if (productType == TK_L2A_56)
-	  for (j=0; j<netDesc->nValidSensor; j++)
-		{
-/******************************************************/
-			memset(&l2a56, 0, sizeof(L2A_56_RAINGAUGE));
-/******************************************************/
-			status = TKreadGauge(ioh, &l2a56);
-			if (status != TK_SUCCESS) TKreportError(status);
-			gnet->gauge[j] = (Gauge *)build_raingauge(&l2a56);
-		}
-	else  /* productType == TK_L2A_57 */
-	  for (j=0; j<netDesc->nValidSensor; j++)
+	IO_HANDLE *ioh = (IO_HANDLE *)hc->ioh;
+	int status;
+
+	status = TKopen(hc->file, hc->productType, TK_READ_ONLY, ioh);
+	if (status != TK_SUCCESS) return(status);
+	hc->open = 1;
+	hc->next = 0;
+	/* Read an array of NETDESC structures from the HDF file. */
+	status = TKreadNetHeader(ioh, nnet, netDesc);
+	if (status != TK_SUCCESS)
+	{
+		TKclose(ioh);
+		hc->open = 0;
+	}
+	return(status);
+}
+
+static int seek_gauge(Ghdf_complex *hc, int k)
+{
+	/* Makes gauge 'k' (in file order) the next one TKreadGauge reads. */
+	IO_HANDLE *ioh = (IO_HANDLE *)hc->ioh;
+	int status;
+#ifdef HAVE_LIBTSDISTK
+	NETDESC *netDesc;
+	int nnet;
+#endif
+
+	if (hc->open && k == hc->next) return(TK_SUCCESS);
+#ifdef HAVE_LIBTSDISTK
+	/* The toolkit only reads forward: reopen when 'k' is behind us,
+		 then read up to it. */
+	if (!hc->open || hc->next < 0 || k < hc->next)
+	{
+		if (hc->open) TKclose(ioh);
+		hc->open = 0;
+		status = open_granule(hc, &nnet, &netDesc);
+		if (status != TK_SUCCESS) return(status);
+		free(netDesc);
+	}
+	for (; hc->next < k; hc->next++)
+	{
+		status = TKreadGauge(ioh, ((L2A_stage *)hc->stage)->l2a);
+		if (status != TK_SUCCESS)
 		{
-/******************************************************/
-			memset(&l2a57, 0, sizeof(L2A_57_DISDROMETER));
-/******************************************************/
-			status = TKreadGauge(ioh, &l2a57);
-			if (status != TK_SUCCESS) TKreportError(status);
-			gnet->gauge[j] = (Gauge *)build_disdrogauge(&l2a57);
+			hc->next = -1;
+			return(status);
 		}
-
-	/* Fill the Gauge_network header values. */
-	gnet->h.name = (char *) strdup(netDesc->networkName);
-	gnet->h.type = (char *) strdup(gnet->gauge[0]->h.type);
-	gnet->h.ngauge = netDesc->nValidSensor;
-	return(gnet);
+	}
+	return(TK_SUCCESS);
+#else
+	if (!hc->open) return(TK_FAIL);
+	status = TKseekGauge(ioh, k);
+	hc->next = (status == TK_SUCCESS) ? k : -1;
+	return(status);
+#endif
 }
 
 /***********************************************************/
 /*                                                         */
-/*                    Ghdf_to_gauge_complex                */
+/*                      Gopen_hdf_complex                  */
 /*                                                         */
 /***********************************************************/
-Gauge_complex *Ghdf_to_gauge_complex(char *hdffile)
+Ghdf_complex *Gopen_hdf_complex(char *hdffile)
 {
-  /* Return gnet upon success.
-   * Return NULL upon failure.
-	 */
-  IO_HANDLE   ioh;
+	/* Opens a 2A-56 or 2A-57 HDF file and reads only its net header.
+		 hc->gc is a Gauge_complex whose networks have their names and
+		 gauge counts, but no gauges: those are read, once, when first
+		 asked for with Ghdf_gauge or Ghdf_network.
+
+		 Until then the networks' gauge[] slots are NULL.  Gprint_network,
+		 Gsite_index_of_complex, Gpolar_lut_of_network and
+		 Gauge_complex_to_hdf_by_day pass over them, Gwrite_binary and
+		 Gauge_complex_to_hdf refuse such a complex; most other GSL
+		 functions expect every slot filled.  Call Ghdf_network
+		 on each network before handing hc->gc to them.  Ghdf_gauge
+		 changes hc->gc, so no other thread may use it meanwhile.
+
+		 Returns: handle, if success.  Close with Gclose_hdf_complex.
+		          NULL, if failure.
+	*/
+	Ghdf_complex *hc;
+	Gauge_complex *gcomplex;
+	Gauge_network *gnet;
   NETDESC   *netDesc; /* Pointer to an array of NETDESC structures.*/
-  Gauge_complex *gcomplex;
   char *fileName;
-  char radarSite[6], productString[6];
-  int j, nnet=0, productType, status;
+  char radarSite[6], productString[6], dateString[8];
+  int j, nnet=0, productType, status, yy, mm, dd;
 
   if (hdffile == NULL) return(NULL);
 	/* Bypass the leading (optional) directory pathname contained in the 
@@ -269,8 +253,11 @@ Gauge_complex *Ghdf_to_gauge_complex(char *hdffile)
 	fileName = strrchr(hdffile, '/');  /* Find leading '/', if exists. */
 	if (fileName != NULL) fileName++;  /* Point 1 char past leading '/'. */
 	else fileName = hdffile;           /* No leading '/'. */
-	/* Get the productType and radarSite out of the filename. */
-	status = sscanf(fileName, "%4s.%*6s.%4s", productString, radarSite);
+	/* Get the productType, date and radarSite out of the filename:
+		 2A56.yymmdd.MELB.hdf, as Gauge_complex_to_hdf_by_day names them. */
+	productString[0] = radarSite[0] = dateString[0] = '\0';
+	status = sscanf(fileName, "%4s.%6s.%4s", productString, dateString,
+									radarSite);
 	if (status == EOF) TKreportError(status);
 
 	if (strncmp(productString, "2A56", 4) == 0)  /* Raingauge */
@@ -283,27 +270,214 @@ Gauge_complex *Ghdf_to_gauge_complex(char *hdffile)
 						fileName);
 		return(NULL);
   }
-	status = TKopen(hdffile, productType, TK_READ_ONLY, &ioh);
-	if (status != TK_SUCCESS) TKreportError(status);
-	/* Read an array of NETDESC structures from the HDF file. */
+
+	hc = (Ghdf_complex *)calloc(1, sizeof(Ghdf_complex));
+	if (hc == NULL) return(NULL);
+	hc->productType = productType;
+	/* The granule holds one day; its records carry only hour and minute. */
+	if (strlen(dateString) == 6 &&
+			sscanf(dateString, "%2d%2d%2d", &yy, &mm, &dd) == 3 &&
+			mm >= 1 && mm <= 12 && dd >= 1 && dd <= 31)
+	{
+		yy += (yy < 70) ? 2000 : 1900;
+		hc->day = Gmake_time_key(yy, Gjulian(mm, dd, yy), 0, 0, 0);
+	}
+	else
+		fprintf(stderr, "Gopen_hdf_complex: no yymmdd date in %s; "
+						"gauge times will be on 1970-01-01.\n", fileName);
+	hc->file = (char *)strdup(hdffile);
+	hc->ioh  = calloc(1, sizeof(IO_HANDLE));
+	hc->stage = new_l2a_stage(productType);
+	if (hc->file == NULL || hc->ioh == NULL || hc->stage == NULL)
+	{
+		Gclose_hdf_complex(hc);
+		return(NULL);
+	}
+	status = open_granule(hc, &nnet, &netDesc);
+	if (status != TK_SUCCESS)
+	{
+		TKreportError(status);
+		Gclose_hdf_complex(hc);
+		return(NULL);
+	}
 	if (nnet == 0)
 	  fprintf(stderr, "Warning: hdf_to_gsl.c: nnet = %d\n", nnet);
-	status = TKreadNetHeader(&ioh, nnet, &netDesc);
-	if (status != TK_SUCCESS) TKreportError(status);
+	if (nnet > MAX_GAUGE_NETWORKS) nnet = MAX_GAUGE_NETWORKS;
 
 	/* Create a Gauge_complex structure, and fill its header values. */
 	gcomplex = (Gauge_complex *)Gnew_gauge_complex(MAX_GAUGE_NETWORKS);
-	gcomplex->h.radarSite = (char *) strdup(radarSite);
-	gcomplex->h.nnet = nnet;
-	/* Read each gauge_network from the HDF file into a GSL 'Gauge_network'
-	   structure. */
+	hc->gc = gcomplex;
+	hc->net_start = (int *)calloc(nnet + 1, sizeof(int));
+	if (gcomplex == NULL || hc->net_start == NULL) goto fail;
+	gcomplex->h.radarSite = Gintern(radarSite);
+
+	/* The networks, without their gauges. */
 	for (j=0; j<nnet; j++)
 	{
-	  gcomplex->net[j] = build_gauge_network(&ioh, &netDesc[j], productType);
-		if (gcomplex->net[j] == NULL) return(NULL);
+		if (netDesc[j].nValidSensor <= 0 ||
+				netDesc[j].nValidSensor > MAX_NETWORK_GAUGES)
+		{
+			fprintf(stderr, "Network %s: bad gauge count %d.\n",
+							netDesc[j].networkName, netDesc[j].nValidSensor);
+			goto fail;
+		}
+		gnet = Gnew_gauge_network(MAX_NETWORK_GAUGES);
+		if (gnet == NULL) goto fail;
+		gnet->h.name = Gintern(netDesc[j].networkName);
+		gnet->h.ngauge = netDesc[j].nValidSensor;
+		gcomplex->net[j] = gnet;
+		gcomplex->h.nnet = j+1;
+		hc->net_start[j+1] = hc->net_start[j] + gnet->h.ngauge;
 	}
+	free(netDesc);
+	if (Gindex_gauge_complex(gcomplex) != OK) goto fail;
+	return(hc);
 
-	TKclose(&ioh);
-	return(gcomplex);
+ fail:
+	free(netDesc);
+	Gclose_hdf_complex(hc);
+	return(NULL);
+}
+
+/***********************************************************/
+/*                                                         */
+/*                     Gclose_hdf_complex                  */
+/*                                                         */
+/***********************************************************/
+void Gclose_hdf_complex(Ghdf_complex *hc)
+{
+	/* Closes the file and frees hc->gc with everything read into it.
+		 To keep the complex, set hc->gc to NULL first.
+	*/
+	if (hc == NULL) return;
+	if (hc->open) TKclose((IO_HANDLE *)hc->ioh);
+	if (hc->ioh) free(hc->ioh);
+	free_l2a_stage((L2A_stage *)hc->stage);
+	Gfree_gauge_complex(hc->gc);
+	if (hc->net_start) free(hc->net_start);
+	if (hc->file) free(hc->file);
+	free(hc);
 }
+
+/***********************************************************/
+/*                                                         */
+/*              Ghdf_gauge / Ghdf_network                  */
+/*                                                         */
+/***********************************************************/
+Gauge *Ghdf_gauge(Ghdf_complex *hc, int net, int i)
+{
+	/* Gauge 'i' of network 'net' (both counted from 0, in file order),
+		 read from the file the first time it is asked for.
+
+		 Returns: the gauge, also at hc->gc->net[net]->gauge[i].
+		          NULL, if there is no such gauge or it cannot be read.
+	*/
+	L2A_stage *stage;
+	Gauge_network *gnet;
+	Gauge *g;
+	int k, status;
+
+	if (hc == NULL || hc->gc == NULL || net < 0 || net >= hc->gc->h.nnet)
+		return(NULL);
+	stage = (L2A_stage *)hc->stage;
+	gnet = hc->gc->net[net];
+	if (i < 0 || i >= gnet->h.ngauge) return(NULL);
+	if (gnet->gauge[i] != NULL) return(gnet->gauge[i]);
+
+	k = hc->net_start[net] + i;
+	status = seek_gauge(hc, k);
+	if (status == TK_SUCCESS)
+	{
+#ifdef HAVE_LIBTSDISTK
+		/* TKreadRaingauge and TKreadDisdrometer (above) set only the
+			 descriptor and the slots they read; the rest keeps the previous
+			 gauge.  (The stand-in toolkit, gsl_tk.c, reads the whole
+			 structure and needs no clearing.) */
+		clear_stage(stage);
 #endif
+		status = TKreadGauge((IO_HANDLE *)hc->ioh, stage->l2a);
+	}
+	if (status != TK_SUCCESS)
+	{
+		TKreportError(status);
+		hc->next = -1;
+		return(NULL);
+	}
+	hc->next = k+1;
+
+	if (hc->productType == TK_L2A_56)
+		g = (Gauge *)build_raingauge((L2A_56_RAINGAUGE *)stage->l2a, hc->day);
+	else  /* productType == TK_L2A_57 */
+		g = (Gauge *)build_disdrogauge((L2A_57_DISDROMETER *)stage->l2a, hc->day);
+	if (g == NULL) return(NULL);
+	stage->nused = g->h.nobs;  /* The slots clear_stage must zero. */
+	g->h.network = gnet->h.name;
+	if (gnet->h.type == NULL) gnet->h.type = g->h.type;
+	gnet->gauge[i] = g;
+	/* The lookup tables (Gfind_gauge_by_number ...) passed over this
+		 slot while it was empty: rebuild them now, so that lookups stay
+		 read-only (see Gindex_gauge_complex).  If out of memory, the
+		 next lookup tries again. */
+	Gclear_index(gnet->by_number);
+	Gclear_index(gnet->by_name);
+	gnet->nindexed = 0;
+	Gindex_gauge_network(gnet);
+	return(g);
+}
+
+Gauge_network *Ghdf_network(Ghdf_complex *hc, int net)
+{
+	/* Network 'net' with all its gauges read (see Ghdf_gauge).
+		 Returns: the network, also at hc->gc->net[net].
+		          NULL, if there is no such network or a gauge cannot be read.
+	*/
+	int i;
+
+	if (hc == NULL || hc->gc == NULL || net < 0 || net >= hc->gc->h.nnet)
+		return(NULL);
+	for (i=0; i<hc->gc->net[net]->h.ngauge; i++)
+		if (Ghdf_gauge(hc, net, i) == NULL) return(NULL);
+	return(hc->gc->net[net]);
+}
+
+Gauge_network *Ghdf_network_by_name(Ghdf_complex *hc, char *netName)
+{
+	/* Like Ghdf_network, for the network called 'netName'. */
+	int j;
+
+	if (hc == NULL || hc->gc == NULL || netName == NULL) return(NULL);
+	for (j=0; j<hc->gc->h.nnet; j++)
+		if (strcmp(hc->gc->net[j]->h.name, netName) == 0)
+			return(Ghdf_network(hc, j));
+	return(NULL);
+}
+
+/***********************************************************/
+/*                                                         */
+/*                    Ghdf_to_gauge_complex                */
+/*                                                         */
+/***********************************************************/
+Gauge_complex *Ghdf_to_gauge_complex(char *hdffile)
+{
+  /* Return gnet upon success.
+   * Return NULL upon failure.
+	 */
+	Ghdf_complex *hc;
+	Gauge_complex *gcomplex;
+	int j;
+
+	hc = Gopen_hdf_complex(hdffile);
+	if (hc == NULL) return(NULL);
+	/* Read each gauge_network from the HDF file into a GSL 'Gauge_network'
+	   structure. */
+	for (j=0; j<hc->gc->h.nnet; j++)
+		if (Ghdf_network(hc, j) == NULL)
+		{
+			Gclose_hdf_complex(hc);
+			return(NULL);
+		}
+	gcomplex = hc->gc;
+	hc->gc = NULL;
+	Gclose_hdf_complex(hc);
+	return(gcomplex);
+}